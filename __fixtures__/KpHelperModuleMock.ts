@@ -1,6 +1,7 @@
 import * as crypto from 'crypto';
 import {Chacha20} from 'ts-chacha20';
 
+import Attachment, {AttachmentStore} from '../src/lib/core/Attachment';
 import {CryptoHashAlgorithm} from '../src/lib/crypto/CryptoHash';
 import {
   Cipher,
@@ -9,6 +10,7 @@ import {
 } from '../src/lib/crypto/SymmetricCipher';
 import {LocalHelperModule} from '../src/lib/utilities/KpHelperModule';
 import Uint8ArrayReader from '../src/lib/utilities/Uint8ArrayReader';
+import Salsa20 from './Salsa20';
 
 const KpHelperModuleMock: Omit<LocalHelperModule, 'module'> = {
   readFile: jest.fn().mockResolvedValue([]),
@@ -101,6 +103,43 @@ const KpHelperModuleMock: Omit<LocalHelperModule, 'module'> = {
                 ? cipher.encrypt(data)
                 : cipher.decrypt(data);
             },
+            seek: async position => {
+              if (!cipher) {
+                throw new Error();
+              }
+              cipher = new Chacha20(key, iv);
+              cipher.encrypt(new Uint8Array(position));
+            },
+            destroy: async () => {
+              if (!cipher) {
+                throw new Error();
+              }
+              cipher = undefined;
+            },
+          };
+        }
+        case SymmetricCipherMode.Salsa20: {
+          let cipher: Salsa20 | undefined = new Salsa20(key, iv);
+
+          return {
+            finish: async data => {
+              if (!cipher) {
+                throw new Error();
+              }
+              return cipher.process(data);
+            },
+            process: async data => {
+              if (!cipher) {
+                throw new Error();
+              }
+              return cipher.process(data);
+            },
+            seek: async position => {
+              if (!cipher) {
+                throw new Error();
+              }
+              cipher.seek(position);
+            },
             destroy: async () => {
               if (!cipher) {
                 throw new Error();
@@ -130,6 +169,9 @@ const KpHelperModuleMock: Omit<LocalHelperModule, 'module'> = {
                 ...cipher.final(),
               ]);
             },
+            seek: async () => {
+              throw new Error('Cipher cannot seek');
+            },
             destroy: async () => {
               if (!cipher) {
                 throw new Error();
@@ -144,6 +186,95 @@ const KpHelperModuleMock: Omit<LocalHelperModule, 'module'> = {
           );
       }
     }),
+  decryptKdbx3Payload: jest
+    .fn<
+      Promise<Uint8Array>,
+      [SymmetricCipherMode, Uint8Array, Uint8Array, Uint8Array, Uint8Array]
+    >()
+    .mockImplementation(async (mode, key, iv, streamStartBytes, data) => {
+      if (mode !== SymmetricCipherMode.Aes256_CBC) {
+        throw new Error(
+          `Cipher ${SymmetricCipherMode[mode]} (${mode}) not mocked`,
+        );
+      }
+
+      // Like the native helper, a padding error and mismatched start bytes
+      // both mean the key is wrong
+      let payload: Buffer;
+      try {
+        const decipher = crypto.createDecipheriv('aes-256-cbc', key, iv);
+        payload = Buffer.concat([decipher.update(data), decipher.final()]);
+      } catch (e) {
+        throw new Error('Wrong key or database file is corrupt');
+      }
+
+      if (!payload.subarray(0, 32).equals(streamStartBytes)) {
+        throw new Error('Wrong key or database file is corrupt');
+      }
+
+      const blocks: Buffer[] = [];
+      let offset = 32;
+      for (let index = 0; ; index++) {
+        if (payload.readUInt32LE(offset) !== index) {
+          throw new Error('Invalid hashed block index');
+        }
+
+        const hash = payload.subarray(offset + 4, offset + 36);
+        const size = payload.readUInt32LE(offset + 36);
+        offset += 40;
+
+        if (size === 0) {
+          break;
+        }
+
+        const block = payload.subarray(offset, offset + size);
+        if (!crypto.createHash('sha256').update(block).digest().equals(hash)) {
+          throw new Error('Hashed block mismatch');
+        }
+
+        blocks.push(block);
+        offset += size;
+      }
+
+      return Uint8Array.from(Buffer.concat(blocks));
+    }),
+  createAttachmentStore: jest
+    .fn<Promise<AttachmentStore>, [boolean?]>()
+    .mockImplementation(async (): Promise<AttachmentStore> => {
+      let attachments: Uint8Array[] | undefined = [];
+
+      return {
+        add: async data => {
+          if (!attachments) {
+            throw new Error();
+          }
+          attachments.push(Uint8Array.from(data));
+          return {id: attachments.length - 1, size: data.byteLength};
+        },
+        write: async (attachment: Attachment) => {
+          if (!attachments?.[attachment.id]) {
+            throw new Error();
+          }
+        },
+        destroy: async () => {
+          if (!attachments) {
+            throw new Error();
+          }
+          attachments = undefined;
+        },
+      };
+    }),
+  matchUrls: jest.fn().mockImplementation(() => {
+    throw new Error('Not implemented');
+  }),
+  writeSnapshot: jest.fn().mockImplementation(() => {
+    throw new Error('Not implemented');
+  }),
+  openSnapshot: jest.fn().mockImplementation(() => {
+    throw new Error('Not implemented');
+  }),
+  deleteSnapshot: jest.fn().mockResolvedValue(undefined),
+  completeFindEntries: jest.fn().mockResolvedValue(undefined),
   challengeResponse: jest
     .fn<Promise<Uint8Array>, [string, Uint8Array]>()
     .mockImplementation(async (_uuid, data) => {
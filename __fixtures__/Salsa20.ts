@@ -0,0 +1,108 @@
+/* eslint-disable no-bitwise */
+
+function rotl(value: number, shift: number): number {
+  return (value << shift) | (value >>> (32 - shift));
+}
+
+function readUInt32LE(bytes: Uint8Array, offset: number): number {
+  return (
+    (bytes[offset] |
+      (bytes[offset + 1] << 8) |
+      (bytes[offset + 2] << 16) |
+      (bytes[offset + 3] << 24)) >>>
+    0
+  );
+}
+
+/**
+ * Minimal Salsa20/20 keystream, only used to mock the native inner random
+ * stream in tests.
+ */
+export default class Salsa20 {
+  private readonly state = new Uint32Array(16);
+  private readonly keystream = new Uint8Array(64);
+  private keystreamOffset = 64;
+
+  constructor(key: Uint8Array, nonce: Uint8Array) {
+    if (key.byteLength !== 32 || nonce.byteLength !== 8) {
+      throw new Error('Invalid Salsa20 key or nonce size');
+    }
+
+    this.state[0] = 0x61707865;
+    this.state[5] = 0x3320646e;
+    this.state[10] = 0x79622d32;
+    this.state[15] = 0x6b206574;
+
+    for (let i = 0; i < 4; i++) {
+      this.state[1 + i] = readUInt32LE(key, i * 4);
+      this.state[11 + i] = readUInt32LE(key, 16 + i * 4);
+    }
+
+    this.state[6] = readUInt32LE(nonce, 0);
+    this.state[7] = readUInt32LE(nonce, 4);
+  }
+
+  process(data: Uint8Array): Uint8Array {
+    const output = new Uint8Array(data.byteLength);
+
+    for (let i = 0; i < data.byteLength; i++) {
+      if (this.keystreamOffset === 64) {
+        this.nextBlock();
+      }
+
+      output[i] = data[i] ^ this.keystream[this.keystreamOffset++];
+    }
+
+    return output;
+  }
+
+  seek(position: number): void {
+    const block = Math.floor(position / 64);
+    this.state[8] = block % 0x100000000;
+    this.state[9] = Math.floor(block / 0x100000000);
+    this.keystreamOffset = 64;
+
+    if (position % 64) {
+      this.nextBlock();
+      this.keystreamOffset = position % 64;
+    }
+  }
+
+  private nextBlock(): void {
+    const x = Uint32Array.from(this.state);
+
+    const quarterRound = (a: number, b: number, c: number, d: number) => {
+      x[b] ^= rotl((x[a] + x[d]) | 0, 7);
+      x[c] ^= rotl((x[b] + x[a]) | 0, 9);
+      x[d] ^= rotl((x[c] + x[b]) | 0, 13);
+      x[a] ^= rotl((x[d] + x[c]) | 0, 18);
+    };
+
+    for (let round = 0; round < 10; round++) {
+      quarterRound(0, 4, 8, 12);
+      quarterRound(5, 9, 13, 1);
+      quarterRound(10, 14, 2, 6);
+      quarterRound(15, 3, 7, 11);
+
+      quarterRound(0, 1, 2, 3);
+      quarterRound(5, 6, 7, 4);
+      quarterRound(10, 11, 8, 9);
+      quarterRound(15, 12, 13, 14);
+    }
+
+    for (let i = 0; i < 16; i++) {
+      const word = (x[i] + this.state[i]) >>> 0;
+      this.keystream[i * 4] = word & 0xff;
+      this.keystream[i * 4 + 1] = (word >>> 8) & 0xff;
+      this.keystream[i * 4 + 2] = (word >>> 16) & 0xff;
+      this.keystream[i * 4 + 3] = (word >>> 24) & 0xff;
+    }
+
+    this.state[8] = (this.state[8] + 1) >>> 0;
+    if (this.state[8] === 0) {
+      this.state[9] = (this.state[9] + 1) >>> 0;
+    }
+
+    this.keystreamOffset = 0;
+  }
+}
@@ -80,4 +80,41 @@ describe('Kbd4Reader', () => {
         ?.attributes.Password,
     ).toEqual('deleted');
   });
+
+  it('can defer reading entry history', async () => {
+    const databaseFile = fs.readFileSync(
+      '__fixtures__/sample-aes256-aes-kdf-kdbx4.kdbx',
+    );
+
+    const password = new PasswordKey();
+    await password.setPassword('sample');
+
+    const reader = new Kdbx4Reader({deferHistory: true});
+    const database = await reader.readDatabase(
+      databaseFile,
+      new CompositeKey([password]),
+    );
+
+    const entry = database.rootGroup?.children?.[0]?.entries?.[0];
+    if (!entry) {
+      throw new Error('Missing sample entry');
+    }
+
+    expect(entry.history).toEqual([]);
+    expect(entry.deferredHistory?.count).toEqual(3);
+
+    // Protected values after the skipped history must still decrypt correctly.
+    const childrenCount = database.rootGroup?.children.length ?? 0;
+    expect(
+      database.rootGroup?.children?.[childrenCount - 1]?.entries?.[0]
+        ?.attributes.Password,
+    ).toEqual('deleted');
+
+    const history = await database.loadHistory(entry);
+
+    expect(history.length).toEqual(3);
+    expect(history[0].attributes.Password).toEqual('');
+    expect(history[1].attributes.Password).toEqual('another-password');
+    expect(entry.deferredHistory).toBeUndefined();
+  });
 });
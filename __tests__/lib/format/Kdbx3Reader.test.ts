@@ -0,0 +1,95 @@
+import * as fs from 'fs';
+
+import Kdbx3Reader from '../../../src/lib/format/Kdbx3Reader';
+import {HeaderFieldId} from '../../../src/lib/format/Keepass2';
+import CompositeKey from '../../../src/lib/keys/CompositeKey';
+import PasswordKey from '../../../src/lib/keys/PasswordKey';
+
+describe('Kdbx3Reader', () => {
+  const databaseFile = fs.readFileSync(
+    '__fixtures__/sample-aes256-aes-kdf-kdbx3.kdbx',
+  );
+
+  async function createKey(password: string): Promise<CompositeKey> {
+    const key = new PasswordKey();
+    await key.setPassword(password);
+    return new CompositeKey([key]);
+  }
+
+  it('can read a database', async () => {
+    const reader = new Kdbx3Reader();
+    const database = await reader.readDatabase(
+      databaseFile,
+      await createKey('sample'),
+    );
+
+    expect(database.metadata.name).toEqual('Sample');
+    expect(database.metadata.historyMaxItems).toEqual(10);
+    expect(database.metadata.nameChanged).toEqual(
+      new Date('2023-01-14T18:04:51Z'),
+    );
+
+    const [entry, otherEntry] = database.rootGroup?.entries ?? [];
+
+    // The protected binary in the metadata comes first in the random stream,
+    // so these only match if it was decrypted in the correct order.
+    expect(entry?.attributes.Password).toEqual('password');
+    expect(entry?.history[0]?.attributes.Password).toEqual('old-password');
+    expect(otherEntry?.attributes.Password).toEqual('another-password');
+    expect(
+      database.rootGroup?.children?.[0]?.entries?.[0]?.attributes.Password,
+    ).toEqual('deleted');
+
+    expect(entry?.attachments['file.txt']?.size).toEqual('attachment'.length);
+    expect(otherEntry?.attachments['secret.txt']?.size).toEqual(
+      'secret attachment'.length,
+    );
+  });
+
+  it('can defer reading entry history', async () => {
+    const reader = new Kdbx3Reader({deferHistory: true});
+    const database = await reader.readDatabase(
+      databaseFile,
+      await createKey('sample'),
+    );
+
+    const entry = database.rootGroup?.entries?.[0];
+    if (!entry) {
+      throw new Error('Missing sample entry');
+    }
+
+    expect(entry.deferredHistory?.count).toEqual(1);
+    expect(database.rootGroup?.entries?.[1]?.attributes.Password).toEqual(
+      'another-password',
+    );
+
+    const history = await database.loadHistory(entry);
+
+    expect(history[0].attributes.Password).toEqual('old-password');
+  });
+
+  it('rejects the wrong key', async () => {
+    const reader = new Kdbx3Reader();
+
+    await expect(
+      reader.readDatabase(databaseFile, await createKey('wrong')),
+    ).rejects.toThrow('Wrong key or database file is corrupt');
+  });
+
+  it('rejects mismatched stream start bytes', async () => {
+    // The key is unchanged so the payload still decrypts, only the start bytes
+    // it is compared against differ
+    const tamperedFile = Buffer.from(databaseFile);
+    let offset = 12;
+    while (tamperedFile[offset] !== HeaderFieldId.StreamStartBytes) {
+      offset += 3 + tamperedFile.readUInt16LE(offset + 1);
+    }
+    tamperedFile[offset + 3] = 0xff - tamperedFile[offset + 3];
+
+    const reader = new Kdbx3Reader();
+
+    await expect(
+      reader.readDatabase(tamperedFile, await createKey('sample')),
+    ).rejects.toThrow('Wrong key or database file is corrupt');
+  });
+});
@@ -0,0 +1,93 @@
+import Entry from '../../../src/lib/core/Entry';
+import Group from '../../../src/lib/core/Group';
+import DomainMatcher, {
+  DomainMatch,
+} from '../../../src/lib/utilities/DomainMatcher';
+import KpHelperModule from '../../../src/lib/utilities/KpHelperModule';
+
+describe('DomainMatcher', () => {
+  const matchUrls = KpHelperModule.matchUrls as jest.Mock;
+
+  function createEntry(attributes: Record<string, string>): Entry {
+    return {
+      attachments: {},
+      attributes,
+      autoTypeAssociations: [],
+      customData: {},
+      history: [],
+      protectedAttributes: [],
+    };
+  }
+
+  function createGroup(entries: Entry[], children: Group[] = []): Group {
+    return {children, customData: {}, entries};
+  }
+
+  beforeEach(() => {
+    const results: Record<string, DomainMatch> = {
+      'https://example.com': DomainMatch.Host,
+      'https://login.example.com': DomainMatch.RegistrableDomain,
+    };
+
+    matchUrls.mockImplementation(async (_query: string, urls: string[]) =>
+      urls.map(url => results[url] ?? DomainMatch.None),
+    );
+  });
+
+  afterEach(() => {
+    matchUrls.mockReset();
+  });
+
+  it('collects URL and KP2A_URL attributes from the whole tree', async () => {
+    const entry = createEntry({
+      URL: 'https://example.com',
+      KP2A_URL: 'https://other.com',
+      KP2A_URL_1: '',
+      Notes: 'https://login.example.com',
+    });
+    const nestedEntry = createEntry({KP2A_URL_2: 'https://nested.com'});
+
+    await DomainMatcher.findEntries(
+      createGroup([entry], [createGroup([nestedEntry])]),
+      'https://example.com',
+    );
+
+    expect(matchUrls).toHaveBeenCalledTimes(1);
+    expect(matchUrls).toHaveBeenCalledWith('https://example.com', [
+      'https://example.com',
+      'https://other.com',
+      'https://nested.com',
+    ]);
+  });
+
+  it('orders entries by their best match', async () => {
+    const registrableEntry = createEntry({URL: 'https://login.example.com'});
+    const hostEntry = createEntry({
+      URL: 'https://unrelated.com',
+      KP2A_URL: 'https://login.example.com',
+      KP2A_URL_1: 'https://example.com',
+    });
+    const unmatchedEntry = createEntry({URL: 'https://unrelated.com'});
+    const otherHostEntry = createEntry({URL: 'https://example.com'});
+
+    const entries = await DomainMatcher.findEntries(
+      createGroup(
+        [registrableEntry, unmatchedEntry],
+        [createGroup([hostEntry, otherHostEntry])],
+      ),
+      'https://example.com',
+    );
+
+    expect(entries).toEqual([hostEntry, otherHostEntry, registrableEntry]);
+  });
+
+  it('does not call the native module without URLs', async () => {
+    const entries = await DomainMatcher.findEntries(
+      createGroup([createEntry({Title: 'No URL'})]),
+      'https://example.com',
+    );
+
+    expect(entries).toEqual([]);
+    expect(matchUrls).not.toHaveBeenCalled();
+  });
+});
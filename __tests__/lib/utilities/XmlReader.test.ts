@@ -169,6 +169,56 @@ describe('XmlReader', () => {
     });
   });
 
+  describe('readCurrentAsString', () => {
+    it('returns the current element and its children', () => {
+      const sut = new XmlReader(
+        '<?xml version="1.0"?>\n' +
+          '<Entry>\n' +
+          ' <History>\n' +
+          '  <Entry><Value Protected="True">YQ==</Value></Entry>\n' +
+          ' </History>\n' +
+          ' <Times />\n' +
+          '</Entry>\n',
+      );
+
+      sut.readNextStartElement();
+      sut.readNextStartElement();
+      expect(sut.current.name).toEqual('History');
+
+      expect(sut.readCurrentAsString()).toEqual(
+        '<History>\n' +
+          '  <Entry><Value Protected="True">YQ==</Value></Entry>\n' +
+          ' </History>',
+      );
+
+      sut.readNextStartElement();
+      expect(sut.current.name).toEqual('Times');
+    });
+  });
+
+  describe('readFromCurrent', () => {
+    it('keeps the range within the original document', () => {
+      const sut = new XmlReader(
+        '<?xml version="1.0"?>\n' +
+          '<Entry>\n' +
+          ' <History>\n' +
+          '  <Entry><Value Protected="True">YQ==</Value></Entry>\n' +
+          ' </History>\n' +
+          '</Entry>\n',
+      );
+
+      sut.readNextStartElement();
+      sut.readNextStartElement();
+      expect(sut.range).toEqual([0, 116]);
+
+      const history = sut.readFromCurrent();
+      expect(history.range).toEqual([31, 106]);
+
+      history.readNextStartElement();
+      expect(history.readFromCurrent().range).toEqual([43, 94]);
+    });
+  });
+
   describe('skipCurrentElement', () => {
     it('skips past close tags of parents', () => {
       const sut = new XmlReader(
@@ -27,10 +27,15 @@ public class FindEntriesService extends HeadlessJsTaskService {
         );
     }
 
-    public static void execute(Context applicationContext, String searchString) {
+    public static void execute(
+            Context applicationContext,
+            String requestId,
+            String searchString
+    ) {
         Intent service = new Intent(applicationContext, FindEntriesService.class);
         Bundle bundle = new Bundle();
 
+        bundle.putString("requestId", requestId);
         bundle.putString("search", searchString);
         service.putExtras(bundle);
 
@@ -3,26 +3,101 @@ package com.keepassrn;
 import android.app.assist.AssistStructure;
 import android.os.Build;
 import android.os.CancellationSignal;
+import android.os.Handler;
+import android.os.Looper;
 import android.service.autofill.AutofillService;
+import android.service.autofill.Dataset;
 import android.service.autofill.FillCallback;
 import android.service.autofill.FillContext;
 import android.service.autofill.FillRequest;
+import android.service.autofill.FillResponse;
 import android.service.autofill.SaveCallback;
 import android.service.autofill.SaveRequest;
 import android.util.Log;
 import android.view.View;
 import android.view.autofill.AutofillId;
+import android.view.autofill.AutofillValue;
+import android.widget.RemoteViews;
 
 import androidx.annotation.NonNull;
 import androidx.annotation.RequiresApi;
 
+import java.util.Collections;
 import java.util.List;
+import java.util.Map;
+import java.util.UUID;
+import java.util.concurrent.ConcurrentHashMap;
 import java.util.stream.Collectors;
 
 @RequiresApi(api = Build.VERSION_CODES.O)
 public class KpAutofillService extends AutofillService {
     private static final String TAG = KpAutofillService.class.getSimpleName();
 
+    // The system gives up on a fill request after a few seconds on its own
+    private static final long FILL_TIMEOUT_MS = 4000;
+
+    private static final Map<String, PendingFill> pendingFills = new ConcurrentHashMap<>();
+
+    public static class FillEntry {
+        public final String title;
+        public final String username;
+        public final String password;
+
+        public FillEntry(String title, String username, String password) {
+            this.title = title;
+            this.username = username;
+            this.password = password;
+        }
+    }
+
+    private static class PendingFill {
+        public final String packageName;
+        public final FoundStructure structure;
+        public final FillCallback callback;
+
+        PendingFill(String packageName, FoundStructure structure, FillCallback callback) {
+            this.packageName = packageName;
+            this.structure = structure;
+            this.callback = callback;
+        }
+    }
+
+    /**
+     * Answers a fill request with the entries found by the FindEntries task.
+     * Requests that already timed out or were cancelled are ignored.
+     */
+    public static void completeFill(String requestId, List<FillEntry> entries) {
+        PendingFill pendingFill = pendingFills.remove(requestId);
+        if (pendingFill == null) {
+            return;
+        }
+
+        if (entries.isEmpty()) {
+            pendingFill.callback.onSuccess(null);
+            return;
+        }
+
+        FillResponse.Builder response = new FillResponse.Builder();
+
+        for (FillEntry entry : entries) {
+            RemoteViews presentation = new RemoteViews(
+                    pendingFill.packageName,
+                    android.R.layout.simple_list_item_1
+            );
+            presentation.setTextViewText(
+                    android.R.id.text1,
+                    entry.username.isEmpty() ? entry.title : entry.title + " (" + entry.username + ")"
+            );
+
+            response.addDataset(new Dataset.Builder(presentation)
+                    .setValue(pendingFill.structure.usernameId, AutofillValue.forText(entry.username))
+                    .setValue(pendingFill.structure.passwordId, AutofillValue.forText(entry.password))
+                    .build());
+        }
+
+        pendingFill.callback.onSuccess(response.build());
+    }
+
     @Override
     public void onFillRequest(
             @NonNull FillRequest fillRequest,
@@ -45,12 +120,21 @@ public class KpAutofillService extends AutofillService {
 
         if (latestStructure == null || !foundStructure.isComplete()) {
             Log.d(TAG, "Incomplete structure found");
+            fillCallback.onSuccess(null);
             return;
         }
 
         String packageName = latestStructure.getActivityComponent().getPackageName();
+        String requestId = UUID.randomUUID().toString();
+
+        pendingFills.put(requestId, new PendingFill(getPackageName(), foundStructure, fillCallback));
+        cancellationSignal.setOnCancelListener(() -> pendingFills.remove(requestId));
+        new Handler(Looper.getMainLooper()).postDelayed(
+                () -> completeFill(requestId, Collections.emptyList()),
+                FILL_TIMEOUT_MS
+        );
 
-        FindEntriesService.execute(getApplicationContext(), packageName);
+        FindEntriesService.execute(getApplicationContext(), requestId, packageName);
     }
 
     @Override
@@ -20,5 +20,42 @@ public class KpHelper {
 
     public static native byte[] finishCipher(String uuid, byte[] data);
 
+    public static native void seekCipher(String uuid, long position);
+
     public static native void destroyCipher(String uuid);
+
+    public static native byte[] decryptKdbx3Payload(
+            int mode,
+            byte[] key,
+            byte[] iv,
+            byte[] streamStartBytes,
+            byte[] data
+    );
+
+    public static native String createAttachmentStore(String directory, boolean encrypted);
+
+    public static native int addAttachment(String uuid, byte[] data);
+
+    public static native void writeAttachment(String uuid, int id, int fd);
+
+    public static native void destroyAttachmentStore(String uuid);
+
+    public static native int[] matchUrls(String query, String[] urls);
+
+    public static native void writeSnapshot(
+            String path,
+            byte[] key,
+            byte[] identity,
+            String[] uuids,
+            String[][] fields,
+            String[][] urls
+    );
+
+    public static native String openSnapshot(String path, byte[] key, byte[] identity);
+
+    public static native int[] findSnapshotEntries(String uuid, String query);
+
+    public static native String[] readSnapshotEntry(String uuid, int index);
+
+    public static native void closeSnapshot(String uuid);
 }
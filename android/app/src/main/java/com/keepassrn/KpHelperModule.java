@@ -1,6 +1,7 @@
 package com.keepassrn;
 
 import android.net.Uri;
+import android.os.Build;
 import android.os.ParcelFileDescriptor;
 
 import androidx.annotation.NonNull;
@@ -10,6 +11,7 @@ import com.facebook.react.bridge.ReactApplicationContext;
 import com.facebook.react.bridge.ReactContextBaseJavaModule;
 import com.facebook.react.bridge.ReactMethod;
 import com.facebook.react.bridge.ReadableArray;
+import com.facebook.react.bridge.ReadableMap;
 import com.facebook.react.bridge.ReadableType;
 import com.facebook.react.bridge.WritableArray;
 import com.facebook.react.bridge.WritableMap;
@@ -23,10 +25,14 @@ import org.signal.argon2.MemoryCost;
 import org.signal.argon2.Type;
 import org.signal.argon2.Version;
 
+import java.io.File;
 import java.io.FileDescriptor;
 import java.io.FileInputStream;
 import java.io.IOException;
+import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.Collection;
+import java.util.List;
 import java.util.Locale;
 
 public class KpHelperModule extends ReactContextBaseJavaModule {
@@ -224,6 +230,21 @@ public class KpHelperModule extends ReactContextBaseJavaModule {
         }
     }
 
+    @ReactMethod
+    public void seekCipher(
+            String uuid,
+            double position,
+            Promise promise
+    ) {
+        try {
+            KpHelper.seekCipher(uuid, (long) position);
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
     @ReactMethod
     public void destroyCipher(
             String uuid,
@@ -238,6 +259,297 @@ public class KpHelperModule extends ReactContextBaseJavaModule {
         }
     }
 
+    @ReactMethod
+    public void decryptKdbx3Payload(
+            double mode,
+            ReadableArray key,
+            ReadableArray iv,
+            ReadableArray streamStartBytes,
+            ReadableArray data,
+            Promise promise
+    ) {
+        try {
+            byte[] payload = KpHelper.decryptKdbx3Payload(
+                    (int) mode,
+                    getBytesFromArray(key),
+                    getBytesFromArray(iv),
+                    getBytesFromArray(streamStartBytes),
+                    getBytesFromArray(data)
+            );
+
+            promise.resolve(getArrayFromBytes(payload));
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void createAttachmentStore(boolean encrypted, Promise promise) {
+        try {
+            String uuid = KpHelper.createAttachmentStore(
+                    getReactApplicationContext().getCacheDir().getAbsolutePath(),
+                    encrypted
+            );
+
+            promise.resolve(uuid);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void addAttachment(
+            String uuid,
+            ReadableArray data,
+            Promise promise
+    ) {
+        try {
+            int id = KpHelper.addAttachment(uuid, getBytesFromArray(data));
+
+            promise.resolve(id);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void writeAttachment(
+            String uuid,
+            double id,
+            String uri,
+            Promise promise
+    ) {
+        try (
+                ParcelFileDescriptor parcelDescriptor = getReactApplicationContext()
+                        .getContentResolver()
+                        .openFileDescriptor(Uri.parse(uri), "wt")
+        ) {
+            KpHelper.writeAttachment(uuid, (int) id, parcelDescriptor.getFd());
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void destroyAttachmentStore(
+            String uuid,
+            Promise promise
+    ) {
+        try {
+            KpHelper.destroyAttachmentStore(uuid);
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void matchUrls(String query, ReadableArray urls, Promise promise) {
+        try {
+            String[] urlStrings = new String[urls.size()];
+
+            for (int i = 0; i < urls.size(); i++) {
+                urlStrings[i] = urls.getType(i) == ReadableType.String ? urls.getString(i) : null;
+            }
+
+            int[] matches = KpHelper.matchUrls(query, urlStrings);
+
+            WritableArray result = new WritableNativeArray();
+            for (int match : matches) {
+                result.pushInt(match);
+            }
+
+            promise.resolve(result);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void writeSnapshot(
+            String name,
+            ReadableArray identity,
+            ReadableArray entries,
+            Promise promise
+    ) {
+        try {
+            // Snapshots are only read by the autofill service
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.O) {
+                promise.resolve(null);
+                return;
+            }
+
+            String[] uuids = new String[entries.size()];
+            String[][] fields = new String[entries.size()][];
+            String[][] urls = new String[entries.size()][];
+
+            for (int i = 0; i < entries.size(); i++) {
+                ReadableMap entry = entries.getMap(i);
+
+                uuids[i] = entry.getString("uuid");
+                fields[i] = getStringsFromArray(entry.getArray("fields"));
+                urls[i] = getStringsFromArray(entry.getArray("urls"));
+            }
+
+            byte[] identityBytes = getBytesFromArray(identity);
+
+            // The new key only replaces the old one once the snapshot it
+            // belongs to is in place, a crash in between leaves a key that
+            // no longer matches the snapshot identity.
+            File keyFile = new File(getSnapshotKeyPath(name));
+            File temporaryKeyFile = new File(keyFile.getPath() + ".tmp");
+            byte[] key = SnapshotKeyStore.createKey(temporaryKeyFile, identityBytes);
+
+            try {
+                KpHelper.writeSnapshot(
+                        getSnapshotPath(name),
+                        key,
+                        identityBytes,
+                        uuids,
+                        fields,
+                        urls
+                );
+            } finally {
+                Arrays.fill(key, (byte) 0);
+            }
+
+            if (!temporaryKeyFile.renameTo(keyFile)) {
+                throw new Exception("Unable to store snapshot key");
+            }
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void openSnapshot(String name, Promise promise) {
+        try {
+            File keyFile = new File(getSnapshotKeyPath(name));
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.O || !keyFile.exists()) {
+                promise.resolve(null);
+                return;
+            }
+
+            SnapshotKeyStore.SnapshotKey key = SnapshotKeyStore.readKey(keyFile);
+
+            try {
+                String uuid = KpHelper.openSnapshot(
+                        getSnapshotPath(name),
+                        key.key,
+                        key.identity
+                );
+
+                promise.resolve(uuid);
+            } finally {
+                Arrays.fill(key.key, (byte) 0);
+            }
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void findSnapshotEntries(String uuid, String query, Promise promise) {
+        try {
+            int[] indexes = KpHelper.findSnapshotEntries(uuid, query);
+
+            WritableArray result = new WritableNativeArray();
+            for (int index : indexes) {
+                result.pushInt(index);
+            }
+
+            promise.resolve(result);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void readSnapshotEntry(String uuid, double index, Promise promise) {
+        try {
+            String[] values = KpHelper.readSnapshotEntry(uuid, (int) index);
+
+            WritableArray result = new WritableNativeArray();
+            for (String value : values) {
+                result.pushString(value);
+            }
+
+            promise.resolve(result);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void closeSnapshot(String uuid, Promise promise) {
+        try {
+            KpHelper.closeSnapshot(uuid);
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void deleteSnapshot(String name, Promise promise) {
+        try {
+            String path = getSnapshotPath(name);
+            String keyPath = getSnapshotKeyPath(name);
+
+            // Leftover temporary files hold the same data as the snapshot
+            for (File file : new File[]{
+                    new File(path),
+                    new File(path + ".tmp"),
+                    new File(keyPath),
+                    new File(keyPath + ".tmp"),
+            }) {
+                if (file.exists() && !file.delete()) {
+                    throw new Exception("Unable to delete snapshot");
+                }
+            }
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
+    @ReactMethod
+    public void completeFindEntries(
+            String requestId,
+            ReadableArray entries,
+            Promise promise
+    ) {
+        try {
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.O) {
+                throw new Exception("Autofill is not supported");
+            }
+
+            List<KpAutofillService.FillEntry> fillEntries = new ArrayList<>();
+            for (int i = 0; i < entries.size(); i++) {
+                ReadableMap entry = entries.getMap(i);
+
+                fillEntries.add(new KpAutofillService.FillEntry(
+                        entry.getString("title"),
+                        entry.getString("username"),
+                        entry.getString("password")
+                ));
+            }
+
+            KpAutofillService.completeFill(requestId, fillEntries);
+
+            promise.resolve(null);
+        } catch (Exception e) {
+            promise.reject(e);
+        }
+    }
+
     @ReactMethod
     public void getHardwareKeys(Promise promise) {
         try {
@@ -320,6 +632,37 @@ public class KpHelperModule extends ReactContextBaseJavaModule {
         return result;
     }
 
+    private String[] getStringsFromArray(ReadableArray array) throws Exception {
+        String[] result = new String[array.size()];
+
+        for (int i = 0; i < array.size(); i++) {
+            if (array.getType(i) != ReadableType.String) {
+                throw new Exception("Invalid string array");
+            }
+
+            result[i] = array.getString(i);
+        }
+
+        return result;
+    }
+
+    private String getSnapshotPath(String name) throws Exception {
+        if (!name.matches("[A-Za-z0-9_-]+")) {
+            throw new Exception("Invalid snapshot name");
+        }
+
+        File directory = new File(getReactApplicationContext().getNoBackupFilesDir(), "snapshots");
+        if (!directory.isDirectory() && !directory.mkdirs()) {
+            throw new Exception("Unable to create snapshot directory");
+        }
+
+        return new File(directory, name + ".snapshot").getAbsolutePath();
+    }
+
+    private String getSnapshotKeyPath(String name) throws Exception {
+        return getSnapshotPath(name) + ".key";
+    }
+
     private WritableArray getArrayFromBytes(byte[] bytes) {
         WritableArray result = new WritableNativeArray();
 
@@ -0,0 +1,128 @@
+package com.keepassrn;
+
+import android.os.Build;
+import android.security.keystore.KeyGenParameterSpec;
+import android.security.keystore.KeyProperties;
+
+import androidx.annotation.RequiresApi;
+
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.security.KeyStore;
+import java.security.SecureRandom;
+import java.util.Arrays;
+
+import javax.crypto.Cipher;
+import javax.crypto.KeyGenerator;
+import javax.crypto.SecretKey;
+import javax.crypto.spec.GCMParameterSpec;
+
+/**
+ * Keeps the random key of a vault snapshot wrapped by an Android Keystore key,
+ * so a snapshot can be opened after a restart without the database keys.
+ *
+ * The key file holds the identity of the snapshot, the GCM IV and the wrapped
+ * key. The identity is authenticated as associated data, a key file only opens
+ * the snapshot it was written with.
+ */
+@RequiresApi(api = Build.VERSION_CODES.M)
+public class SnapshotKeyStore {
+    private static final String KEYSTORE = "AndroidKeyStore";
+    private static final String ALIAS = "keepassrn_snapshot";
+    private static final String TRANSFORMATION = "AES/GCM/NoPadding";
+
+    private static final int KEY_SIZE = 32;
+    private static final int IDENTITY_SIZE = 32;
+    private static final int IV_SIZE = 12;
+    private static final int TAG_SIZE = 16;
+
+    public static class SnapshotKey {
+        public final byte[] key;
+        public final byte[] identity;
+
+        SnapshotKey(byte[] key, byte[] identity) {
+            this.key = key;
+            this.identity = identity;
+        }
+    }
+
+    public static byte[] createKey(File file, byte[] identity) throws Exception {
+        if (identity.length != IDENTITY_SIZE) {
+            throw new Exception("Invalid snapshot identity");
+        }
+
+        byte[] key = new byte[KEY_SIZE];
+        new SecureRandom().nextBytes(key);
+
+        Cipher cipher = Cipher.getInstance(TRANSFORMATION);
+        cipher.init(Cipher.ENCRYPT_MODE, getWrappingKey());
+        cipher.updateAAD(identity);
+
+        byte[] iv = cipher.getIV();
+        byte[] wrapped = cipher.doFinal(key);
+
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(identity);
+            stream.write(iv);
+            stream.write(wrapped);
+            stream.getFD().sync();
+        }
+
+        return key;
+    }
+
+    public static SnapshotKey readKey(File file) throws Exception {
+        byte[] identity = new byte[IDENTITY_SIZE];
+        byte[] iv = new byte[IV_SIZE];
+        byte[] wrapped = new byte[KEY_SIZE + TAG_SIZE];
+
+        if (file.length() != identity.length + iv.length + wrapped.length) {
+            throw new Exception("Invalid snapshot key");
+        }
+
+        try (DataInputStream stream = new DataInputStream(new FileInputStream(file))) {
+            stream.readFully(identity);
+            stream.readFully(iv);
+            stream.readFully(wrapped);
+        }
+
+        Cipher cipher = Cipher.getInstance(TRANSFORMATION);
+        cipher.init(
+                Cipher.DECRYPT_MODE,
+                getWrappingKey(),
+                new GCMParameterSpec(TAG_SIZE * 8, iv)
+        );
+        cipher.updateAAD(identity);
+
+        byte[] key = cipher.doFinal(wrapped);
+        Arrays.fill(wrapped, (byte) 0);
+
+        return new SnapshotKey(key, identity);
+    }
+
+    private static SecretKey getWrappingKey() throws Exception {
+        KeyStore keyStore = KeyStore.getInstance(KEYSTORE);
+        keyStore.load(null);
+
+        KeyStore.Entry entry = keyStore.getEntry(ALIAS, null);
+        if (entry instanceof KeyStore.SecretKeyEntry) {
+            return ((KeyStore.SecretKeyEntry) entry).getSecretKey();
+        }
+
+        // Autofill needs the snapshot while the app is locked, so the wrapping
+        // key cannot require user authentication. It never leaves the Keystore.
+        KeyGenerator generator = KeyGenerator.getInstance(KeyProperties.KEY_ALGORITHM_AES, KEYSTORE);
+        generator.init(new KeyGenParameterSpec.Builder(
+                ALIAS,
+                KeyProperties.PURPOSE_ENCRYPT | KeyProperties.PURPOSE_DECRYPT
+        )
+                .setBlockModes(KeyProperties.BLOCK_MODE_GCM)
+                .setEncryptionPaddings(KeyProperties.ENCRYPTION_PADDING_NONE)
+                .setKeySize(256)
+                .build());
+
+        return generator.generateKey();
+    }
+}
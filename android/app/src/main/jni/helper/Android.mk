@@ -8,7 +8,7 @@ include $(PREBUILT_SHARED_LIBRARY)
 
 include $(CLEAR_VARS)
 LOCAL_MODULE := helper
-LOCAL_SRC_FILES := KpHelper.cpp JniHelpers.cpp
+LOCAL_SRC_FILES := KpHelper.cpp JniHelpers.cpp AttachmentStore.cpp DomainMatcher.cpp VaultSnapshot.cpp ParallelCbc.cpp HashedBlockStream.cpp
 LOCAL_C_INCLUDES := JniHelpers.h
 LOCAL_SHARED_LIBRARIES := botan
 LOCAL_LDLIBS := -llog
@@ -1,2 +1,6 @@
 APP_CPPFLAGS += -fexceptions
+APP_CPPFLAGS += -std=c++17
+# Building the public suffix hash table at compile time needs more constexpr
+# evaluation steps than clang allows by default once the full list is used.
+APP_CPPFLAGS += -fconstexpr-steps=100000000
 APP_STL := c++_shared
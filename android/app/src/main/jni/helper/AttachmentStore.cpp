@@ -0,0 +1,169 @@
+#include <botan/auto_rng.h>
+#include <botan/stream_cipher.h>
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "AttachmentStore.h"
+
+const size_t AttachmentStore_minimumGrowth = 1024 * 1024;
+const size_t AttachmentStore_chunkSize = 64 * 1024;
+
+AttachmentStore::AttachmentStore(const std::string &directory, bool encrypted)
+        : encrypted(encrypted) {
+    std::string path = directory + "/attachments-XXXXXX";
+    std::vector<char> pathTemplate(path.begin(), path.end());
+    pathTemplate.push_back('\0');
+
+    fd = mkstemp(pathTemplate.data());
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create attachment store file");
+    }
+
+    // The file only needs to be reachable through our descriptor, unlinking it
+    // now ensures it is cleaned up even if the process is killed.
+    unlink(pathTemplate.data());
+
+    if (encrypted) {
+        Botan::AutoSeeded_RNG rng;
+        sessionKey = rng.random_vec(32);
+    }
+}
+
+AttachmentStore::~AttachmentStore() {
+    if (mapping != nullptr) {
+        munmap(mapping, capacity);
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+size_t AttachmentStore::add(const Botan::byte *data, size_t length) {
+    reserve(used + length);
+
+    size_t id = records.size();
+    records.push_back({used, length});
+
+    if (!encrypted) {
+        std::copy(data, data + length, mapping + used);
+    } else {
+        // The mapping is shared with the cache file, so plaintext must never be
+        // written to it, not even briefly. Each chunk is encrypted aside first.
+        Botan::secure_vector<Botan::byte> buffer(std::min(AttachmentStore_chunkSize, length));
+
+        for (size_t position = 0; position < length;) {
+            size_t chunkLength = std::min(AttachmentStore_chunkSize, length - position);
+
+            std::copy(data + position, data + position + chunkLength, buffer.begin());
+            crypt(id, position, buffer.data(), chunkLength);
+            std::copy(buffer.begin(), buffer.begin() + chunkLength, mapping + used + position);
+
+            position += chunkLength;
+        }
+    }
+
+    used += length;
+
+    return id;
+}
+
+size_t AttachmentStore::count() const {
+    return records.size();
+}
+
+size_t AttachmentStore::size(size_t id) const {
+    if (id >= records.size()) {
+        throw std::out_of_range("Unknown attachment");
+    }
+
+    return records[id].length;
+}
+
+void AttachmentStore::writeTo(size_t id, int outputFd) const {
+    if (id >= records.size()) {
+        throw std::out_of_range("Unknown attachment");
+    }
+
+    const Record &record = records[id];
+    Botan::secure_vector<Botan::byte> buffer(AttachmentStore_chunkSize);
+
+    for (size_t position = 0; position < record.length;) {
+        size_t chunkLength = std::min(AttachmentStore_chunkSize, record.length - position);
+        const Botan::byte *source = mapping + record.offset + position;
+
+        std::copy(source, source + chunkLength, buffer.begin());
+        crypt(id, position, buffer.data(), chunkLength);
+
+        size_t written = 0;
+        while (written < chunkLength) {
+            ssize_t result = write(outputFd, buffer.data() + written, chunkLength - written);
+            if (result == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::runtime_error("Failed to write attachment");
+            }
+
+            written += result;
+        }
+
+        position += chunkLength;
+    }
+}
+
+void AttachmentStore::reserve(size_t required) {
+    if (required <= capacity) {
+        return;
+    }
+
+    auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t newCapacity = std::max({required, capacity * 2, AttachmentStore_minimumGrowth});
+    newCapacity = (newCapacity + pageSize - 1) / pageSize * pageSize;
+
+    if (ftruncate(fd, static_cast<off_t>(newCapacity)) == -1) {
+        throw std::runtime_error("Failed to grow attachment store file");
+    }
+
+    if (mapping != nullptr) {
+        munmap(mapping, capacity);
+        mapping = nullptr;
+    }
+
+    void *newMapping = mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (newMapping == MAP_FAILED) {
+        capacity = 0;
+        throw std::runtime_error("Failed to map attachment store file");
+    }
+
+    mapping = static_cast<Botan::byte *>(newMapping);
+    capacity = newCapacity;
+}
+
+void AttachmentStore::crypt(
+        size_t id,
+        size_t position,
+        Botan::byte *data,
+        size_t length
+) const {
+    if (!encrypted) {
+        return;
+    }
+
+    // Each attachment gets its own nonce, so the record index is enough to
+    // keep the keystreams unique under a single session key.
+    Botan::byte nonce[12] = {0};
+    for (size_t i = 0; i < sizeof(size_t) && i < sizeof(nonce); i++) {
+        nonce[i] = static_cast<Botan::byte>(id >> (i * 8));
+    }
+
+    auto cipher = Botan::StreamCipher::create_or_throw("ChaCha(20)");
+    cipher->set_key(sessionKey.data(), sessionKey.size());
+    cipher->set_iv(nonce, sizeof(nonce));
+    cipher->seek(position);
+    cipher->cipher1(data, length);
+}
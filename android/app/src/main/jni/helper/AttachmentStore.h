@@ -0,0 +1,54 @@
+#ifndef KEEPASSRN_ATTACHMENTSTORE_H
+#define KEEPASSRN_ATTACHMENTSTORE_H
+
+#include <botan/secmem.h>
+#include <botan/types.h>
+#include <string>
+#include <vector>
+
+/**
+ * Holds the inner header binaries of an unlocked database outside the JS heap.
+ *
+ * Binaries are appended to an unlinked, memory-mapped temp file and indexed by
+ * their pool ID (the order they were added in). When encryption is enabled
+ * each binary is encrypted with ChaCha20 under a random session key that only
+ * lives for as long as the store does.
+ */
+class AttachmentStore {
+public:
+    AttachmentStore(const std::string &directory, bool encrypted);
+
+    ~AttachmentStore();
+
+    AttachmentStore(const AttachmentStore &) = delete;
+
+    AttachmentStore &operator=(const AttachmentStore &) = delete;
+
+    size_t add(const Botan::byte *data, size_t length);
+
+    size_t count() const;
+
+    size_t size(size_t id) const;
+
+    void writeTo(size_t id, int outputFd) const;
+
+private:
+    struct Record {
+        size_t offset;
+        size_t length;
+    };
+
+    void reserve(size_t required);
+
+    void crypt(size_t id, size_t position, Botan::byte *data, size_t length) const;
+
+    int fd = -1;
+    Botan::byte *mapping = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool encrypted;
+    Botan::secure_vector<Botan::byte> sessionKey;
+    std::vector<Record> records;
+};
+
+#endif //KEEPASSRN_ATTACHMENTSTORE_H
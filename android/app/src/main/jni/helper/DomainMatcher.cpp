@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "DomainMatcher.h"
+#include "PublicSuffixTable.h"
+
+const char DomainMatcher_packageScheme[] = "androidapp://";
+
+bool DomainMatcher_isIpAddress(const std::string &host) {
+    if (!host.empty() && host.front() == '[') {
+        return true;
+    }
+
+    return std::all_of(host.begin(), host.end(), [](char c) {
+        return c == '.' || std::isdigit(static_cast<unsigned char>(c));
+    });
+}
+
+bool DomainMatcher_decodeUtf8(std::string_view input, std::u32string &output) {
+    for (size_t i = 0; i < input.size();) {
+        auto lead = static_cast<uint8_t>(input[i]);
+        size_t length;
+        char32_t codePoint;
+
+        if (lead < 0x80) {
+            length = 1;
+            codePoint = lead;
+        } else if ((lead & 0xe0) == 0xc0) {
+            length = 2;
+            codePoint = lead & 0x1f;
+        } else if ((lead & 0xf0) == 0xe0) {
+            length = 3;
+            codePoint = lead & 0x0f;
+        } else if ((lead & 0xf8) == 0xf0) {
+            length = 4;
+            codePoint = lead & 0x07;
+        } else {
+            return false;
+        }
+
+        if (i + length > input.size()) {
+            return false;
+        }
+
+        for (size_t j = 1; j < length; j++) {
+            auto continuation = static_cast<uint8_t>(input[i + j]);
+            if ((continuation & 0xc0) != 0x80) {
+                return false;
+            }
+            codePoint = (codePoint << 6) | (continuation & 0x3f);
+        }
+
+        // Reject overlong forms, surrogates and values past the Unicode range
+        static const char32_t minimums[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (codePoint < minimums[length] || codePoint > 0x10ffff
+            || (codePoint >= 0xd800 && codePoint <= 0xdfff)) {
+            return false;
+        }
+
+        output.push_back(codePoint);
+        i += length;
+    }
+
+    return true;
+}
+
+char32_t DomainMatcher_toLower(char32_t c) {
+    // Only the scripts with case that commonly appear in domain names are
+    // folded here, hosts copied from a browser are already lower case.
+    if ((c >= 'A' && c <= 'Z')
+        || (c >= 0xc0 && c <= 0xde && c != 0xd7)
+        || (c >= 0x391 && c <= 0x3ab && c != 0x3a2)
+        || (c >= 0x410 && c <= 0x42f)) {
+        return c + 0x20;
+    }
+
+    if (c >= 0x400 && c <= 0x40f) {
+        return c + 0x50;
+    }
+
+    return c;
+}
+
+size_t DomainMatcher_punycodeAdapt(size_t delta, size_t points, bool first) {
+    delta = first ? delta / 700 : delta / 2;
+    delta += delta / points;
+
+    size_t k = 0;
+    while (delta > ((36 - 1) * 26) / 2) {
+        delta /= 36 - 1;
+        k += 36;
+    }
+
+    return k + (36 * delta) / (delta + 38);
+}
+
+// RFC 3492 with the IDNA parameters, returns an empty string on overflow
+std::string DomainMatcher_punycode(const std::u32string &label) {
+    const auto digit = [](size_t d) {
+        return static_cast<char>(d < 26 ? 'a' + d : '0' + d - 26);
+    };
+
+    std::string output;
+    for (char32_t c: label) {
+        if (c < 0x80) {
+            output.push_back(static_cast<char>(c));
+        }
+    }
+
+    size_t basicCount = output.size();
+    size_t handled = basicCount;
+    if (basicCount > 0) {
+        output.push_back('-');
+    }
+
+    char32_t n = 0x80;
+    size_t delta = 0;
+    size_t bias = 72;
+
+    while (handled < label.size()) {
+        char32_t next = 0x10ffff;
+        for (char32_t c: label) {
+            if (c >= n && c < next) {
+                next = c;
+            }
+        }
+
+        if ((next - n) > (UINT32_MAX - delta) / (handled + 1)) {
+            return {};
+        }
+        delta += (next - n) * (handled + 1);
+        n = next;
+
+        for (char32_t c: label) {
+            if (c < n && ++delta > UINT32_MAX) {
+                return {};
+            }
+
+            if (c == n) {
+                size_t q = delta;
+                for (size_t k = 36;; k += 36) {
+                    size_t t = k <= bias ? 1 : k >= bias + 26 ? 26 : k - bias;
+                    if (q < t) {
+                        break;
+                    }
+                    output.push_back(digit(t + (q - t) % (36 - t)));
+                    q = (q - t) / (36 - t);
+                }
+
+                output.push_back(digit(q));
+                bias = DomainMatcher_punycodeAdapt(delta, handled + 1, handled == basicCount);
+                delta = 0;
+                handled++;
+            }
+        }
+
+        delta++;
+        n++;
+    }
+
+    return output;
+}
+
+/**
+ * Converts the non-ASCII labels of a UTF-8 host to punycode so they compare
+ * equal to the ACE form and hit the punycode public suffix rules. Returns an
+ * empty string for hosts that are not valid UTF-8.
+ */
+std::string DomainMatcher_toAscii(const std::string &host) {
+    if (std::all_of(host.begin(), host.end(), [](char c) {
+        return static_cast<uint8_t>(c) < 0x80;
+    })) {
+        return host;
+    }
+
+    std::u32string codePoints;
+    if (!DomainMatcher_decodeUtf8(host, codePoints)) {
+        return {};
+    }
+
+    std::string result;
+    std::u32string label;
+
+    for (size_t i = 0; i <= codePoints.size(); i++) {
+        char32_t c = i < codePoints.size() ? codePoints[i] : U'.';
+
+        // The ideographic and fullwidth full stops also separate labels
+        if (c != U'.' && c != 0x3002 && c != 0xff0e && c != 0xff61) {
+            label.push_back(DomainMatcher_toLower(c));
+            continue;
+        }
+
+        if (std::all_of(label.begin(), label.end(), [](char32_t l) { return l < 0x80; })) {
+            for (char32_t l: label) {
+                result.push_back(static_cast<char>(l));
+            }
+        } else {
+            auto encoded = DomainMatcher_punycode(label);
+            if (encoded.empty()) {
+                return {};
+            }
+            result.append("xn--").append(encoded);
+        }
+
+        if (i < codePoints.size()) {
+            result.push_back('.');
+        }
+        label.clear();
+    }
+
+    return result;
+}
+
+DomainTarget DomainMatcher_normalize(const std::string &input) {
+    DomainTarget target;
+
+    auto first = std::find_if_not(input.begin(), input.end(), [](char c) {
+        return std::isspace(static_cast<unsigned char>(c));
+    });
+    auto last = std::find_if_not(input.rbegin(), input.rend(), [](char c) {
+        return std::isspace(static_cast<unsigned char>(c));
+    }).base();
+    if (first >= last) {
+        return target;
+    }
+
+    std::string value(first, last);
+    std::transform(value.begin(), value.end(), value.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+
+    if (value.rfind(DomainMatcher_packageScheme, 0) == 0) {
+        auto packageName = value.substr(sizeof(DomainMatcher_packageScheme) - 1);
+        target.packageName = packageName.substr(0, packageName.find('/'));
+        return target;
+    }
+
+    size_t authorityStart = 0;
+    size_t schemeEnd = value.find("://");
+    if (schemeEnd != std::string::npos && schemeEnd < value.find_first_of("/?#")) {
+        authorityStart = schemeEnd + 3;
+    }
+
+    size_t authorityEnd = value.find_first_of("/?#", authorityStart);
+    std::string authority = value.substr(
+            authorityStart,
+            authorityEnd == std::string::npos ? std::string::npos : authorityEnd - authorityStart
+    );
+
+    size_t userInfoEnd = authority.rfind('@');
+    if (userInfoEnd != std::string::npos) {
+        authority.erase(0, userInfoEnd + 1);
+    }
+
+    if (!authority.empty() && authority.front() == '[') {
+        target.host = authority.substr(0, authority.find(']') + 1);
+    } else {
+        target.host = DomainMatcher_toAscii(authority.substr(0, authority.find(':')));
+    }
+
+    while (!target.host.empty() && target.host.back() == '.') {
+        target.host.pop_back();
+    }
+
+    target.registrableDomain = DomainMatcher_registrableDomain(target.host);
+
+    return target;
+}
+
+std::string DomainMatcher_registrableDomain(const std::string &host) {
+    if (host.empty() || DomainMatcher_isIpAddress(host)) {
+        return {};
+    }
+
+    std::vector<size_t> labelStarts = {0};
+    for (size_t i = 0; i < host.size(); i++) {
+        if (host[i] == '.') {
+            if (i + 1 == host.size() || i == labelStarts.back()) {
+                return {};
+            }
+            labelStarts.push_back(i + 1);
+        }
+    }
+
+    size_t labelCount = labelStarts.size();
+
+    // The implicit "*" rule makes the last label a public suffix when nothing
+    // else matches. Candidates are checked longest first, so the first match
+    // is the prevailing rule.
+    size_t suffixLabels = 1;
+    std::string rule;
+    std::string_view hostView(host);
+
+    for (size_t label = 0; label < labelCount; label++) {
+        auto candidate = hostView.substr(labelStarts[label]);
+
+        rule.assign("!").append(candidate);
+        if (PublicSuffixTable::contains(rule)) {
+            suffixLabels = labelCount - label - 1;
+            break;
+        }
+
+        if (PublicSuffixTable::contains(candidate)) {
+            suffixLabels = labelCount - label;
+            break;
+        }
+
+        if (label + 1 < labelCount) {
+            rule.assign("*.").append(hostView.substr(labelStarts[label + 1]));
+            if (PublicSuffixTable::contains(rule)) {
+                suffixLabels = labelCount - label;
+                break;
+            }
+        }
+    }
+
+    if (suffixLabels >= labelCount) {
+        return {};
+    }
+
+    return host.substr(labelStarts[labelCount - suffixLabels - 1]);
+}
+
+DomainMatch DomainMatcher_match(const DomainTarget &query, const DomainTarget &candidate) {
+    // Any app can pick a package name that looks like someone else's domain,
+    // so packages only ever match the same package. Linking an app to a web
+    // domain needs verified proof (Digital Asset Links) and is not done here.
+    if (!query.packageName.empty() || !candidate.packageName.empty()) {
+        return query.packageName == candidate.packageName ? PackageMatch : NoMatch;
+    }
+
+    if (!query.host.empty() && query.host == candidate.host) {
+        return HostMatch;
+    }
+
+    if (!query.registrableDomain.empty()
+        && query.registrableDomain == candidate.registrableDomain) {
+        return RegistrableDomainMatch;
+    }
+
+    return NoMatch;
+}
@@ -0,0 +1,31 @@
+#ifndef KEEPASSRN_DOMAINMATCHER_H
+#define KEEPASSRN_DOMAINMATCHER_H
+
+#include <string>
+
+enum DomainMatch {
+    NoMatch = 0,
+    RegistrableDomainMatch = 1,
+    HostMatch = 2,
+    PackageMatch = 3,
+};
+
+/**
+ * A URL or Android package name reduced to the parts used for matching.
+ *
+ * Package names (written as androidapp://com.example.app) have no host or
+ * registrable domain, they only match the same package name.
+ */
+struct DomainTarget {
+    std::string host;
+    std::string packageName;
+    std::string registrableDomain;
+};
+
+DomainTarget DomainMatcher_normalize(const std::string &input);
+
+std::string DomainMatcher_registrableDomain(const std::string &host);
+
+DomainMatch DomainMatcher_match(const DomainTarget &query, const DomainTarget &candidate);
+
+#endif //KEEPASSRN_DOMAINMATCHER_H
@@ -0,0 +1,74 @@
+#include <botan/hash.h>
+#include <botan/mem_ops.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "HashedBlockStream.h"
+
+const size_t HashedBlockStream_hashSize = 32;
+const size_t HashedBlockStream_headerSize = 4 + HashedBlockStream_hashSize + 4;
+
+uint32_t HashedBlockStream_readUInt32(const Botan::byte *data) {
+    return static_cast<uint32_t>(data[0])
+           | (static_cast<uint32_t>(data[1]) << 8)
+           | (static_cast<uint32_t>(data[2]) << 16)
+           | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void HashedBlockStream_read(Botan::secure_vector<Botan::byte> &data, size_t offset) {
+    auto sha256 = Botan::HashFunction::create_or_throw("SHA-256");
+    Botan::secure_vector<Botan::byte> blockHash(HashedBlockStream_hashSize);
+
+    size_t position = offset;
+    size_t written = 0;
+    uint32_t expectedIndex = 0;
+
+    while (true) {
+        if (data.size() - position < HashedBlockStream_headerSize) {
+            throw std::runtime_error("Truncated hashed block header");
+        }
+
+        const Botan::byte *header = data.data() + position;
+        uint32_t index = HashedBlockStream_readUInt32(header);
+        const Botan::byte *expectedHash = header + 4;
+        uint32_t blockSize = HashedBlockStream_readUInt32(header + 4 + HashedBlockStream_hashSize);
+        position += HashedBlockStream_headerSize;
+
+        if (index != expectedIndex) {
+            throw std::runtime_error("Invalid hashed block index");
+        }
+        expectedIndex++;
+
+        if (blockSize == 0) {
+            bool isZero = std::all_of(expectedHash, expectedHash + HashedBlockStream_hashSize, [](Botan::byte b) {
+                return b == 0;
+            });
+            if (!isZero) {
+                throw std::runtime_error("Invalid hash of final block");
+            }
+            break;
+        }
+
+        if (data.size() - position < blockSize) {
+            throw std::runtime_error("Truncated hashed block data");
+        }
+
+        sha256->update(data.data() + position, blockSize);
+        sha256->final(blockHash.data());
+        if (!Botan::constant_time_compare(blockHash.data(), expectedHash, HashedBlockStream_hashSize)) {
+            throw std::runtime_error("Hashed block mismatch");
+        }
+
+        // The output always trails the input by at least one block header, so
+        // the ranges never overlap in the wrong direction.
+        std::copy(
+                data.begin() + position,
+                data.begin() + position + blockSize,
+                data.begin() + written
+        );
+        position += blockSize;
+        written += blockSize;
+    }
+
+    data.resize(written);
+}
@@ -0,0 +1,17 @@
+#ifndef KEEPASSRN_HASHEDBLOCKSTREAM_H
+#define KEEPASSRN_HASHEDBLOCKSTREAM_H
+
+#include <botan/secmem.h>
+#include <botan/types.h>
+
+/**
+ * Unwraps the KDBX 3.1 hashed block stream starting at offset, in place.
+ *
+ * Each block is a little-endian block index, the SHA-256 hash of the block
+ * data, the data size and the data itself. The stream ends with an empty block
+ * whose hash is all zeroes. Every block is verified before its data is moved
+ * down, so on success the buffer holds only the joined block data.
+ */
+void HashedBlockStream_read(Botan::secure_vector<Botan::byte> &data, size_t offset);
+
+#endif //KEEPASSRN_HASHEDBLOCKSTREAM_H
@@ -3,6 +3,7 @@
 #include <jni.h>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 jbyteArray convertByteVectorToJbyteArray(
         JNIEnv *env,
@@ -64,6 +65,67 @@ std::string convertJstringToString(JNIEnv *env, jstring str) {
     return asString;
 }
 
+std::string convertJstringToUtf8String(JNIEnv *env, jstring str) {
+    auto pointer = env->GetStringUTFChars(str, nullptr);
+    if (pointer == nullptr) {
+        return {};
+    }
+
+    std::string asString(pointer);
+
+    env->ReleaseStringUTFChars(str, pointer);
+
+    return asString;
+}
+
+std::vector<std::string> convertJobjectArrayToStringVector(JNIEnv *env, jobjectArray array) {
+    std::vector<std::string> result;
+
+    int arrayLength = env->GetArrayLength(array);
+    result.reserve(arrayLength);
+
+    for (int index = 0; index < arrayLength; index++) {
+        auto element = reinterpret_cast<jstring>(env->GetObjectArrayElement(array, index));
+        if (element == nullptr) {
+            result.emplace_back();
+            continue;
+        }
+
+        result.push_back(convertJstringToUtf8String(env, element));
+
+        env->DeleteLocalRef(element);
+    }
+
+    return result;
+}
+
+jobjectArray convertStringVectorToJobjectArray(
+        JNIEnv *env,
+        const std::vector<std::string> &strings
+) {
+    jclass stringClass = env->FindClass("java/lang/String");
+    if (stringClass == nullptr) {
+        return nullptr;
+    }
+
+    auto result = env->NewObjectArray((jsize) strings.size(), stringClass, nullptr);
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t index = 0; index < strings.size(); index++) {
+        auto element = env->NewStringUTF(strings[index].c_str());
+        if (element == nullptr) {
+            return nullptr;
+        }
+
+        env->SetObjectArrayElement(result, (jsize) index, element);
+        env->DeleteLocalRef(element);
+    }
+
+    return result;
+}
+
 jint throwException(JNIEnv *env, const char *message) {
     jclass exClass = env->FindClass("java/lang/Exception");
     if (exClass == nullptr) {
@@ -13,6 +13,15 @@ Botan::secure_vector<Botan::byte> convertJbyteArrayToByteVector(
 
 std::string convertJstringToString(JNIEnv *env, jstring str);
 
+std::string convertJstringToUtf8String(JNIEnv *env, jstring str);
+
+std::vector<std::string> convertJobjectArrayToStringVector(JNIEnv *env, jobjectArray array);
+
+jobjectArray convertStringVectorToJobjectArray(
+        JNIEnv *env,
+        const std::vector<std::string> &strings
+);
+
 jint throwException(JNIEnv *env, const char *message);
 
 jint throwIllegalArgumentException(JNIEnv *env, const char *message);
@@ -5,15 +5,25 @@
 #include <botan/cipher_mode.h>
 #include <botan/hash.h>
 #include <botan/hmac.h>
+#include <botan/mem_ops.h>
+#include <botan/stream_cipher.h>
 #include <botan/types.h>
 #include <botan/uuid.h>
 #include <map>
+#include <vector>
 
+#include "AttachmentStore.h"
+#include "DomainMatcher.h"
+#include "HashedBlockStream.h"
 #include "JniHelpers.h"
+#include "ParallelCbc.h"
+#include "VaultSnapshot.h"
 
 const char LogTag[] = "KpHelper";
 
-std::map<std::string, std::unique_ptr<Botan::Cipher_Mode>> activeCiphers;
+std::map<std::string, std::unique_ptr<AttachmentStore>> activeAttachmentStores;
+
+std::map<std::string, std::unique_ptr<VaultSnapshot>> activeSnapshots;
 
 bool SymmetricCipher_aesKdf(
         const Botan::secure_vector<Botan::byte> &key,
@@ -62,6 +72,20 @@ enum SymmetricCipherDirection {
     Encrypt
 };
 
+struct ActiveCipher {
+    std::unique_ptr<Botan::Cipher_Mode> cipher;
+    SymmetricCipherMode mode;
+    SymmetricCipherDirection direction;
+    Botan::secure_vector<Botan::byte> key;
+    // The IV, then the last ciphertext block passed through processCipher
+    Botan::secure_vector<Botan::byte> chainingValue;
+    // Replaces the mode once a stream cipher has been seeked, Cipher_Mode has
+    // no way to move its keystream position
+    std::unique_ptr<Botan::StreamCipher> streamCipher;
+};
+
+std::map<std::string, std::unique_ptr<ActiveCipher>> activeCiphers;
+
 std::string SymmetricCipher_modeToString(const SymmetricCipherMode mode) {
     switch (mode) {
         case Aes128_CBC:
@@ -91,6 +115,42 @@ std::string SymmetricCipher_modeToString(const SymmetricCipherMode mode) {
     }
 }
 
+std::string SymmetricCipher_cbcBlockCipher(const SymmetricCipherMode mode) {
+    switch (mode) {
+        case Aes128_CBC:
+            return "AES-128";
+        case Aes256_CBC:
+            return "AES-256";
+        case Twofish_CBC:
+            return "Twofish";
+        default:
+            return {};
+    }
+}
+
+std::string SymmetricCipher_streamCipher(const SymmetricCipherMode mode) {
+    switch (mode) {
+        case Salsa20:
+            return "Salsa20";
+        case ChaCha20:
+            return "ChaCha(20)";
+        default:
+            return {};
+    }
+}
+
+bool SymmetricCipher_canDecryptInParallel(
+        const SymmetricCipherMode mode,
+        const SymmetricCipherDirection direction,
+        const Botan::secure_vector<Botan::byte> &iv,
+        const Botan::secure_vector<Botan::byte> &data
+) {
+    return direction == Decrypt
+           && !SymmetricCipher_cbcBlockCipher(mode).empty()
+           && data.size() >= ParallelCbc_minimumSize
+           && data.size() % iv.size() == 0;
+}
+
 extern "C" {
 
 JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_transformAesKdfKey(
@@ -267,6 +327,11 @@ JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_cipher(
             return nullptr;
         }
 
+        if (SymmetricCipher_canDecryptInParallel(mode, direction, iv, data)) {
+            ParallelCbc_decrypt(SymmetricCipher_cbcBlockCipher(mode), key, iv, data);
+            return convertByteVectorToJbyteArray(env, data);
+        }
+
         cipher->start(reinterpret_cast<const uint8_t *>(iv.data()), iv.size());
 
         cipher->finish(data);
@@ -336,7 +401,13 @@ JNIEXPORT jstring JNICALL Java_com_keepassrn_KpHelper_createCipher(
         Botan::AutoSeeded_RNG rng;
         Botan::UUID randomUuid(rng);
         auto cipherUuid = randomUuid.to_string();
-        activeCiphers[cipherUuid] = std::move(cipher);
+        activeCiphers[cipherUuid] = std::unique_ptr<ActiveCipher>(new ActiveCipher{
+                std::move(cipher),
+                mode,
+                direction,
+                key,
+                iv,
+        });
 
         __android_log_print(
                 ANDROID_LOG_DEBUG,
@@ -381,7 +452,19 @@ JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_processCipher(
     }
 
     try {
-        activeCiphers[uuid]->process(data.data(), data.size());
+        auto &active = activeCiphers[uuid];
+
+        if (active->direction == Decrypt
+            && !SymmetricCipher_cbcBlockCipher(active->mode).empty()
+            && data.size() >= active->chainingValue.size()) {
+            active->chainingValue.assign(data.end() - active->chainingValue.size(), data.end());
+        }
+
+        if (active->streamCipher) {
+            active->streamCipher->cipher1(data.data(), data.size());
+        } else {
+            active->cipher->process(data.data(), data.size());
+        }
     } catch (...) {
         __android_log_print(
                 ANDROID_LOG_DEBUG,
@@ -418,7 +501,28 @@ JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_finishCipher(
     }
 
     try {
-        activeCiphers[uuid]->finish(data);
+        auto &active = activeCiphers[uuid];
+
+        // The padding is only known once the final block is decrypted, so
+        // large CBC payloads are split across threads instead of going
+        // through the single-threaded Botan mode.
+        if (SymmetricCipher_canDecryptInParallel(
+                active->mode,
+                active->direction,
+                active->chainingValue,
+                data
+        )) {
+            ParallelCbc_decrypt(
+                    SymmetricCipher_cbcBlockCipher(active->mode),
+                    active->key,
+                    active->chainingValue,
+                    data
+            );
+        } else if (active->streamCipher) {
+            active->streamCipher->cipher1(data.data(), data.size());
+        } else {
+            active->cipher->finish(data);
+        }
     } catch (...) {
         __android_log_print(
                 ANDROID_LOG_DEBUG,
@@ -431,6 +535,55 @@ JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_finishCipher(
     return convertByteVectorToJbyteArray(env, data);
 }
 
+JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_seekCipher(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString,
+        jlong position
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return;
+    }
+
+    if (position < 0) {
+        throwIllegalArgumentException(env, "Invalid position");
+        return;
+    }
+
+    if (activeCiphers.find(uuid) == activeCiphers.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return;
+    }
+
+    auto &active = activeCiphers[uuid];
+    auto streamCipherName = SymmetricCipher_streamCipher(active->mode);
+    if (streamCipherName.empty()) {
+        throwIllegalArgumentException(env, "Cipher cannot seek");
+        return;
+    }
+
+    try {
+        if (!active->streamCipher) {
+            auto streamCipher = Botan::StreamCipher::create_or_throw(streamCipherName);
+            streamCipher->set_key(active->key.data(), active->key.size());
+            streamCipher->set_iv(active->chainingValue.data(), active->chainingValue.size());
+            active->streamCipher = std::move(streamCipher);
+        }
+
+        active->streamCipher->seek(static_cast<uint64_t>(position));
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "seekCipher: Exception caught"
+        );
+
+        throwException(env, "Failed to seek cipher");
+    }
+}
+
 JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_destroyCipher(
         JNIEnv *env,
         jclass,
@@ -450,4 +603,483 @@ JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_destroyCipher(
     activeCiphers.erase(uuid);
 }
 
+JNIEXPORT jstring JNICALL Java_com_keepassrn_KpHelper_createAttachmentStore(
+        JNIEnv *env,
+        jclass,
+        jstring directoryString,
+        jboolean encrypted
+) {
+    auto directory = convertJstringToString(env, directoryString);
+    if (directory.empty()) {
+        throwIllegalArgumentException(env, "Missing directory");
+        return nullptr;
+    }
+
+    try {
+        auto store = std::make_unique<AttachmentStore>(directory, encrypted == JNI_TRUE);
+
+        Botan::AutoSeeded_RNG rng;
+        Botan::UUID randomUuid(rng);
+        auto storeUuid = randomUuid.to_string();
+        activeAttachmentStores[storeUuid] = std::move(store);
+
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "createAttachmentStore: Created store %s",
+                storeUuid.c_str()
+        );
+
+        return env->NewStringUTF(storeUuid.c_str());
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "createAttachmentStore: Exception caught"
+        );
+
+        throwException(env, "Failed to create attachment store");
+        return nullptr;
+    }
+}
+
+JNIEXPORT jint JNICALL Java_com_keepassrn_KpHelper_addAttachment(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString,
+        jbyteArray dataArray
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return -1;
+    }
+
+    if (activeAttachmentStores.find(uuid) == activeAttachmentStores.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return -1;
+    }
+
+    // Empty attachments are valid, so the data is not required to have content
+    auto data = convertJbyteArrayToByteVector(env, dataArray);
+
+    try {
+        auto id = activeAttachmentStores[uuid]->add(data.data(), data.size());
+
+        return static_cast<jint>(id);
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "addAttachment: Exception caught"
+        );
+
+        throwException(env, "Failed to store attachment");
+        return -1;
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_writeAttachment(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString,
+        jint id,
+        jint fd
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return;
+    }
+
+    if (activeAttachmentStores.find(uuid) == activeAttachmentStores.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return;
+    }
+
+    auto &store = activeAttachmentStores[uuid];
+    if (id < 0 || static_cast<size_t>(id) >= store->count()) {
+        throwIllegalArgumentException(env, "Unknown attachment");
+        return;
+    }
+
+    if (fd < 0) {
+        throwIllegalArgumentException(env, "Invalid file descriptor");
+        return;
+    }
+
+    try {
+        store->writeTo(static_cast<size_t>(id), fd);
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "writeAttachment: Exception caught"
+        );
+
+        throwException(env, "Failed to write attachment");
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_destroyAttachmentStore(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return;
+    }
+
+    if (activeAttachmentStores.find(uuid) == activeAttachmentStores.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return;
+    }
+
+    activeAttachmentStores.erase(uuid);
+}
+
+JNIEXPORT jintArray JNICALL Java_com_keepassrn_KpHelper_matchUrls(
+        JNIEnv *env,
+        jclass,
+        jstring queryString,
+        jobjectArray urlArray
+) {
+    auto query = DomainMatcher_normalize(convertJstringToUtf8String(env, queryString));
+    if (query.host.empty() && query.packageName.empty()) {
+        throwIllegalArgumentException(env, "Missing query");
+        return nullptr;
+    }
+
+    int urlCount = env->GetArrayLength(urlArray);
+    std::vector<jint> matches(urlCount, NoMatch);
+
+    for (int urlIndex = 0; urlIndex < urlCount; urlIndex++) {
+        auto urlPointer = reinterpret_cast<jstring>(
+                env->GetObjectArrayElement(urlArray, urlIndex)
+        );
+        if (urlPointer == nullptr) {
+            continue;
+        }
+
+        auto candidate = DomainMatcher_normalize(convertJstringToUtf8String(env, urlPointer));
+        matches[urlIndex] = DomainMatcher_match(query, candidate);
+
+        // Batches can cover every entry in the database, which would otherwise
+        // overflow the local reference table.
+        env->DeleteLocalRef(urlPointer);
+    }
+
+    auto result = env->NewIntArray(urlCount);
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    env->SetIntArrayRegion(result, 0, urlCount, matches.data());
+    return result;
+}
+
+JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_writeSnapshot(
+        JNIEnv *env,
+        jclass,
+        jstring pathString,
+        jbyteArray keyArray,
+        jbyteArray identityArray,
+        jobjectArray uuidArray,
+        jobjectArray fieldArrays,
+        jobjectArray urlArrays
+) {
+    auto path = convertJstringToUtf8String(env, pathString);
+    if (path.empty()) {
+        throwIllegalArgumentException(env, "Missing path");
+        return;
+    }
+
+    auto key = convertJbyteArrayToByteVector(env, keyArray);
+    if (key.size() != 32) {
+        throwIllegalArgumentException(env, "Invalid key");
+        return;
+    }
+
+    auto identity = convertJbyteArrayToByteVector(env, identityArray);
+    if (identity.size() != 32) {
+        throwIllegalArgumentException(env, "Invalid identity");
+        return;
+    }
+
+    auto uuids = convertJobjectArrayToStringVector(env, uuidArray);
+    if (env->GetArrayLength(fieldArrays) != (jsize) uuids.size()
+        || env->GetArrayLength(urlArrays) != (jsize) uuids.size()) {
+        throwIllegalArgumentException(env, "Mismatched entry data");
+        return;
+    }
+
+    std::vector<SnapshotEntry> entries(uuids.size());
+    for (size_t index = 0; index < uuids.size(); index++) {
+        auto fields = reinterpret_cast<jobjectArray>(
+                env->GetObjectArrayElement(fieldArrays, (jsize) index)
+        );
+        auto urls = reinterpret_cast<jobjectArray>(
+                env->GetObjectArrayElement(urlArrays, (jsize) index)
+        );
+        if (fields == nullptr || urls == nullptr) {
+            throwIllegalArgumentException(env, "Missing entry data");
+            return;
+        }
+
+        entries[index].uuid = uuids[index];
+        entries[index].fields = convertJobjectArrayToStringVector(env, fields);
+        entries[index].urls = convertJobjectArrayToStringVector(env, urls);
+
+        env->DeleteLocalRef(fields);
+        env->DeleteLocalRef(urls);
+    }
+
+    try {
+        VaultSnapshot::write(path, key, identity, entries);
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "writeSnapshot: Exception caught"
+        );
+
+        throwException(env, "Failed to write snapshot");
+    }
+}
+
+JNIEXPORT jstring JNICALL Java_com_keepassrn_KpHelper_openSnapshot(
+        JNIEnv *env,
+        jclass,
+        jstring pathString,
+        jbyteArray keyArray,
+        jbyteArray identityArray
+) {
+    auto path = convertJstringToUtf8String(env, pathString);
+    if (path.empty()) {
+        throwIllegalArgumentException(env, "Missing path");
+        return nullptr;
+    }
+
+    auto key = convertJbyteArrayToByteVector(env, keyArray);
+    if (key.size() != 32) {
+        throwIllegalArgumentException(env, "Invalid key");
+        return nullptr;
+    }
+
+    auto identity = convertJbyteArrayToByteVector(env, identityArray);
+    if (identity.size() != 32) {
+        throwIllegalArgumentException(env, "Invalid identity");
+        return nullptr;
+    }
+
+    try {
+        auto snapshot = std::make_unique<VaultSnapshot>(path, key, identity);
+
+        Botan::AutoSeeded_RNG rng;
+        Botan::UUID randomUuid(rng);
+        auto snapshotUuid = randomUuid.to_string();
+        activeSnapshots[snapshotUuid] = std::move(snapshot);
+
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "openSnapshot: Opened snapshot %s",
+                snapshotUuid.c_str()
+        );
+
+        return env->NewStringUTF(snapshotUuid.c_str());
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "openSnapshot: Exception caught"
+        );
+
+        throwException(env, "Failed to open snapshot");
+        return nullptr;
+    }
+}
+
+JNIEXPORT jintArray JNICALL Java_com_keepassrn_KpHelper_findSnapshotEntries(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString,
+        jstring queryString
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return nullptr;
+    }
+
+    if (activeSnapshots.find(uuid) == activeSnapshots.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return nullptr;
+    }
+
+    auto query = convertJstringToUtf8String(env, queryString);
+    if (query.empty()) {
+        throwIllegalArgumentException(env, "Missing query");
+        return nullptr;
+    }
+
+    auto found = activeSnapshots[uuid]->find(query);
+    std::vector<jint> indexes(found.begin(), found.end());
+
+    auto result = env->NewIntArray((jsize) indexes.size());
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    env->SetIntArrayRegion(result, 0, (jsize) indexes.size(), indexes.data());
+    return result;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_keepassrn_KpHelper_readSnapshotEntry(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString,
+        jint index
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return nullptr;
+    }
+
+    if (activeSnapshots.find(uuid) == activeSnapshots.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return nullptr;
+    }
+
+    auto &snapshot = activeSnapshots[uuid];
+    if (index < 0 || static_cast<uint32_t>(index) >= snapshot->count()) {
+        throwIllegalArgumentException(env, "Unknown entry");
+        return nullptr;
+    }
+
+    try {
+        return convertStringVectorToJobjectArray(env, snapshot->read(index));
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "readSnapshotEntry: Exception caught"
+        );
+
+        throwException(env, "Failed to read snapshot entry");
+        return nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_keepassrn_KpHelper_closeSnapshot(
+        JNIEnv *env,
+        jclass,
+        jstring uuidString
+) {
+    auto uuid = convertJstringToString(env, uuidString);
+    if (uuid.empty()) {
+        throwIllegalArgumentException(env, "Missing UUID");
+        return;
+    }
+
+    if (activeSnapshots.find(uuid) == activeSnapshots.end()) {
+        throwIllegalArgumentException(env, "Unknown UUID");
+        return;
+    }
+
+    activeSnapshots.erase(uuid);
+}
+
+JNIEXPORT jbyteArray JNICALL Java_com_keepassrn_KpHelper_decryptKdbx3Payload(
+        JNIEnv *env,
+        jclass,
+        jint cipherMode,
+        jbyteArray keyArray,
+        jbyteArray ivArray,
+        jbyteArray streamStartBytesArray,
+        jbyteArray dataArray
+) {
+    auto key = convertJbyteArrayToByteVector(env, keyArray);
+    if (key.empty()) {
+        throwIllegalArgumentException(env, "Missing key");
+        return nullptr;
+    }
+
+    auto iv = convertJbyteArrayToByteVector(env, ivArray);
+    if (iv.empty()) {
+        throwIllegalArgumentException(env, "Missing IV");
+        return nullptr;
+    }
+
+    auto streamStartBytes = convertJbyteArrayToByteVector(env, streamStartBytesArray);
+    if (streamStartBytes.size() != 32) {
+        throwIllegalArgumentException(env, "Invalid stream start bytes");
+        return nullptr;
+    }
+
+    auto data = convertJbyteArrayToByteVector(env, dataArray);
+    if (data.empty()) {
+        throwIllegalArgumentException(env, "Missing data");
+        return nullptr;
+    }
+
+    auto mode = static_cast<SymmetricCipherMode>(cipherMode);
+    auto botanMode = SymmetricCipher_modeToString(mode);
+    if (botanMode.empty()) {
+        throwIllegalArgumentException(env, "Invalid mode");
+        return nullptr;
+    }
+
+    try {
+        if (SymmetricCipher_canDecryptInParallel(mode, Decrypt, iv, data)) {
+            ParallelCbc_decrypt(SymmetricCipher_cbcBlockCipher(mode), key, iv, data);
+        } else {
+            auto cipher = Botan::Cipher_Mode::create_or_throw(botanMode, Botan::DECRYPTION);
+            cipher->set_key(key.data(), key.size());
+            cipher->start(iv.data(), iv.size());
+            cipher->finish(data);
+        }
+    } catch (...) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "decryptKdbx3Payload: Exception caught while decrypting"
+        );
+
+        throwException(env, "Wrong key or database file is corrupt");
+        return nullptr;
+    }
+
+    // The first bytes of the payload are a copy of a header field, which is
+    // the only way to tell a wrong key apart from a corrupt file.
+    if (data.size() < streamStartBytes.size()
+        || !Botan::constant_time_compare(
+            data.data(),
+            streamStartBytes.data(),
+            streamStartBytes.size()
+    )) {
+        throwException(env, "Wrong key or database file is corrupt");
+        return nullptr;
+    }
+
+    try {
+        HashedBlockStream_read(data, streamStartBytes.size());
+    } catch (const std::exception &e) {
+        __android_log_print(
+                ANDROID_LOG_DEBUG,
+                LogTag,
+                "decryptKdbx3Payload: %s",
+                e.what()
+        );
+
+        throwException(env, e.what());
+        return nullptr;
+    }
+
+    return convertByteVectorToJbyteArray(env, data);
+}
+
 }
@@ -0,0 +1,152 @@
+#include <botan/block_cipher.h>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ParallelCbc.h"
+
+const size_t ParallelCbc_minimumSegmentSize = 256 * 1024;
+const size_t ParallelCbc_chunkSize = 64 * 1024;
+
+void ParallelCbc_decryptSegment(
+        const std::string &blockCipherName,
+        const Botan::secure_vector<Botan::byte> &key,
+        const Botan::secure_vector<Botan::byte> &chainingValue,
+        Botan::byte *segment,
+        size_t segmentSize
+) {
+    auto cipher = Botan::BlockCipher::create_or_throw(blockCipherName);
+    cipher->set_key(key.data(), key.size());
+
+    size_t blockSize = cipher->block_size();
+    Botan::secure_vector<Botan::byte> previous(chainingValue);
+    Botan::secure_vector<Botan::byte> ciphertext(ParallelCbc_chunkSize);
+
+    // Decrypting in place would overwrite the ciphertext the next block needs,
+    // so each chunk is copied aside first and decrypted back into the payload.
+    for (size_t position = 0; position < segmentSize; position += ParallelCbc_chunkSize) {
+        size_t chunkSize = std::min(ParallelCbc_chunkSize, segmentSize - position);
+        Botan::byte *chunk = segment + position;
+
+        std::copy(chunk, chunk + chunkSize, ciphertext.begin());
+        cipher->decrypt_n(ciphertext.data(), chunk, chunkSize / blockSize);
+
+        for (size_t i = 0; i < blockSize; i++) {
+            chunk[i] ^= previous[i];
+        }
+        for (size_t i = blockSize; i < chunkSize; i++) {
+            chunk[i] ^= ciphertext[i - blockSize];
+        }
+
+        std::copy(
+                ciphertext.begin() + chunkSize - blockSize,
+                ciphertext.begin() + chunkSize,
+                previous.begin()
+        );
+    }
+}
+
+void ParallelCbc_decrypt(
+        const std::string &blockCipherName,
+        const Botan::secure_vector<Botan::byte> &key,
+        const Botan::secure_vector<Botan::byte> &iv,
+        Botan::secure_vector<Botan::byte> &data
+) {
+    size_t blockSize = iv.size();
+    if (blockSize == 0 || data.empty() || data.size() % blockSize != 0) {
+        throw std::invalid_argument("Invalid CBC payload size");
+    }
+
+    size_t blockCount = data.size() / blockSize;
+    size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, std::max<size_t>(1, data.size() / ParallelCbc_minimumSegmentSize));
+
+    size_t blocksPerSegment = (blockCount + threadCount - 1) / threadCount;
+    // Keep segments a whole number of chunks so only the last chunk is short
+    size_t blocksPerChunk = ParallelCbc_chunkSize / blockSize;
+    blocksPerSegment = (blocksPerSegment + blocksPerChunk - 1) / blocksPerChunk * blocksPerChunk;
+
+    struct Segment {
+        size_t offset;
+        size_t size;
+        Botan::secure_vector<Botan::byte> chainingValue;
+    };
+
+    std::vector<Segment> segments;
+    for (size_t block = 0; block < blockCount; block += blocksPerSegment) {
+        size_t offset = block * blockSize;
+        size_t size = std::min(blocksPerSegment, blockCount - block) * blockSize;
+
+        Botan::secure_vector<Botan::byte> chainingValue = offset == 0
+                ? iv
+                : Botan::secure_vector<Botan::byte>(
+                        data.begin() + offset - blockSize,
+                        data.begin() + offset
+                );
+
+        segments.push_back({offset, size, std::move(chainingValue)});
+    }
+
+    std::vector<std::exception_ptr> errors(segments.size());
+    std::vector<std::thread> workers;
+
+    auto decryptSegment = [&](size_t index) {
+        try {
+            ParallelCbc_decryptSegment(
+                    blockCipherName,
+                    key,
+                    segments[index].chainingValue,
+                    data.data() + segments[index].offset,
+                    segments[index].size
+            );
+        } catch (...) {
+            errors[index] = std::current_exception();
+        }
+    };
+
+    // Reserved up front so the only thing that can throw below is starting a
+    // thread, while no workers are running yet
+    workers.reserve(segments.size() - 1);
+
+    // The calling thread takes the first segment rather than waiting idle
+    size_t segmentIndex = 1;
+    for (; segmentIndex < segments.size(); segmentIndex++) {
+        try {
+            workers.emplace_back(decryptSegment, segmentIndex);
+        } catch (const std::system_error &) {
+            // Out of threads, the calling thread picks up the remaining segments
+            break;
+        }
+    }
+
+    decryptSegment(0);
+    for (; segmentIndex < segments.size(); segmentIndex++) {
+        decryptSegment(segmentIndex);
+    }
+
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    for (auto &error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    Botan::byte padding = data.back();
+    if (padding == 0 || padding > blockSize) {
+        throw std::runtime_error("Invalid CBC padding");
+    }
+
+    for (size_t i = data.size() - padding; i < data.size(); i++) {
+        if (data[i] != padding) {
+            throw std::runtime_error("Invalid CBC padding");
+        }
+    }
+
+    data.resize(data.size() - padding);
+}
@@ -0,0 +1,29 @@
+#ifndef KEEPASSRN_PARALLELCBC_H
+#define KEEPASSRN_PARALLELCBC_H
+
+#include <botan/secmem.h>
+#include <botan/types.h>
+#include <string>
+
+/**
+ * Payloads smaller than this are not worth the cost of starting threads.
+ */
+const size_t ParallelCbc_minimumSize = 1024 * 1024;
+
+/**
+ * Decrypts a complete CBC payload and removes its PKCS#7 padding.
+ *
+ * Each plaintext block only depends on its own ciphertext block and the one
+ * before it, so the payload is split into block aligned segments that are
+ * decrypted on separate threads. The chaining value of every segment is taken
+ * from the ciphertext before any thread starts, and the padding is checked
+ * once all segments are done.
+ */
+void ParallelCbc_decrypt(
+        const std::string &blockCipherName,
+        const Botan::secure_vector<Botan::byte> &key,
+        const Botan::secure_vector<Botan::byte> &iv,
+        Botan::secure_vector<Botan::byte> &data
+);
+
+#endif //KEEPASSRN_PARALLELCBC_H
@@ -0,0 +1,157 @@
+#ifndef KEEPASSRN_PUBLICSUFFIXTABLE_H
+#define KEEPASSRN_PUBLICSUFFIXTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+/**
+ * The Public Suffix List rules, hashed into a minimal perfect hash table by the
+ * compiler so lookups are a couple of hashes and one string comparison.
+ *
+ * The table uses hash-and-displace: every rule is assigned a bucket with an
+ * unseeded hash, then each bucket is given either a seed that moves all of its
+ * rules into free slots, or (for single rule buckets) the slot directly.
+ */
+namespace PublicSuffixTable {
+
+constexpr std::string_view Rules[] = {
+#include "PublicSuffixRules.inc"
+};
+
+constexpr size_t RuleCount = sizeof(Rules) / sizeof(Rules[0]);
+
+constexpr size_t MaxBucketSize = 16;
+
+constexpr uint32_t hash(uint32_t seed, std::string_view value) {
+    // FNV-1a, with the seed mixed into the offset basis
+    uint32_t result = 2166136261u ^ (seed * 16777619u);
+    for (char c: value) {
+        result ^= static_cast<uint8_t>(c);
+        result *= 16777619u;
+    }
+    return result;
+}
+
+struct Table {
+    int32_t displacements[RuleCount];
+    uint32_t slots[RuleCount];
+};
+
+constexpr Table build() {
+    Table table{};
+
+    uint32_t bucketOf[RuleCount]{};
+    uint32_t bucketSizes[RuleCount]{};
+    size_t maxBucketSize = 0;
+
+    for (size_t rule = 0; rule < RuleCount; rule++) {
+        bucketOf[rule] = hash(0, Rules[rule]) % RuleCount;
+        bucketSizes[bucketOf[rule]]++;
+
+        if (bucketSizes[bucketOf[rule]] > maxBucketSize) {
+            maxBucketSize = bucketSizes[bucketOf[rule]];
+        }
+    }
+
+    if (maxBucketSize > MaxBucketSize) {
+        throw std::logic_error("Public suffix bucket too large");
+    }
+
+    // Group the rules by bucket so each bucket's members are contiguous
+    uint32_t bucketStarts[RuleCount + 1]{};
+    for (size_t bucket = 0; bucket < RuleCount; bucket++) {
+        bucketStarts[bucket + 1] = bucketStarts[bucket] + bucketSizes[bucket];
+    }
+
+    uint32_t members[RuleCount]{};
+    uint32_t bucketFill[RuleCount]{};
+    for (size_t rule = 0; rule < RuleCount; rule++) {
+        auto bucket = bucketOf[rule];
+        members[bucketStarts[bucket] + bucketFill[bucket]++] = rule;
+    }
+
+    bool slotUsed[RuleCount]{};
+
+    // Place the largest buckets first while there is the most room for them
+    for (size_t size = maxBucketSize; size > 1; size--) {
+        for (size_t bucket = 0; bucket < RuleCount; bucket++) {
+            if (bucketSizes[bucket] != size) {
+                continue;
+            }
+
+            for (uint32_t seed = 1;; seed++) {
+                uint32_t candidates[MaxBucketSize]{};
+                bool placed = true;
+
+                for (size_t member = 0; member < size && placed; member++) {
+                    auto rule = members[bucketStarts[bucket] + member];
+                    auto slot = hash(seed, Rules[rule]) % RuleCount;
+
+                    if (slotUsed[slot]) {
+                        placed = false;
+                    }
+
+                    for (size_t other = 0; other < member && placed; other++) {
+                        if (candidates[other] == slot) {
+                            placed = false;
+                        }
+                    }
+
+                    candidates[member] = slot;
+                }
+
+                if (!placed) {
+                    continue;
+                }
+
+                for (size_t member = 0; member < size; member++) {
+                    slotUsed[candidates[member]] = true;
+                    table.slots[candidates[member]] = members[bucketStarts[bucket] + member];
+                }
+
+                table.displacements[bucket] = static_cast<int32_t>(seed);
+                break;
+            }
+        }
+    }
+
+    // The remaining buckets hold a single rule and can take any free slot
+    size_t freeSlot = 0;
+    for (size_t bucket = 0; bucket < RuleCount; bucket++) {
+        if (bucketSizes[bucket] != 1) {
+            continue;
+        }
+
+        while (slotUsed[freeSlot]) {
+            freeSlot++;
+        }
+
+        slotUsed[freeSlot] = true;
+        table.slots[freeSlot] = members[bucketStarts[bucket]];
+        table.displacements[bucket] = -static_cast<int32_t>(freeSlot) - 1;
+    }
+
+    return table;
+}
+
+constexpr Table HashTable = build();
+
+constexpr bool contains(std::string_view rule) {
+    auto displacement = HashTable.displacements[hash(0, rule) % RuleCount];
+    auto slot = displacement < 0
+                ? static_cast<size_t>(-(displacement + 1))
+                : hash(static_cast<uint32_t>(displacement), rule) % RuleCount;
+
+    return Rules[HashTable.slots[slot]] == rule;
+}
+
+static_assert(contains("com"), "Public suffix table is missing \"com\"");
+static_assert(!contains("example.com"), "Public suffix table matched \"example.com\"");
+// 公司.cn, internationalized rules are stored in their punycode form
+static_assert(contains("xn--55qx5d.cn"), "Public suffix table is missing \"xn--55qx5d.cn\"");
+
+}
+
+#endif //KEEPASSRN_PUBLICSUFFIXTABLE_H
@@ -0,0 +1,426 @@
+#include <botan/aead.h>
+#include <botan/auto_rng.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "VaultSnapshot.h"
+
+const char VaultSnapshot_magic[8] = {'K', 'P', 'R', 'N', 'S', 'N', 'A', 'P'};
+const uint32_t VaultSnapshot_version = 2;
+
+const size_t VaultSnapshot_headerSize = 96;
+const size_t VaultSnapshot_noncePrefixSize = 16;
+const size_t VaultSnapshot_identitySize = 32;
+const size_t VaultSnapshot_tableRowSize = 16;
+
+const char VaultSnapshot_cipher[] = "ChaCha20Poly1305";
+
+struct VaultSnapshot_Header {
+    uint32_t version;
+    uint32_t entryCount;
+    Botan::byte noncePrefix[VaultSnapshot_noncePrefixSize];
+    uint64_t entryTableOffset;
+    uint64_t urlIndexOffset;
+    uint64_t urlIndexLength;
+    Botan::byte identity[VaultSnapshot_identitySize];
+};
+
+template<typename Buffer>
+void VaultSnapshot_appendUInt32(Buffer &output, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        output.push_back(static_cast<Botan::byte>(value >> (i * 8)));
+    }
+}
+
+template<typename Buffer>
+void VaultSnapshot_appendUInt64(Buffer &output, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        output.push_back(static_cast<Botan::byte>(value >> (i * 8)));
+    }
+}
+
+template<typename Buffer>
+void VaultSnapshot_appendString(Buffer &output, const std::string &value) {
+    VaultSnapshot_appendUInt32(output, static_cast<uint32_t>(value.size()));
+    output.insert(output.end(), value.begin(), value.end());
+}
+
+uint32_t VaultSnapshot_readUInt32(const Botan::byte *data) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+uint64_t VaultSnapshot_readUInt64(const Botan::byte *data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/**
+ * Bounds checked reader over a decrypted record.
+ */
+class VaultSnapshot_RecordReader {
+public:
+    explicit VaultSnapshot_RecordReader(const Botan::secure_vector<Botan::byte> &data)
+            : data(data) {}
+
+    bool atEnd() const {
+        return position == data.size();
+    }
+
+    uint32_t readUInt32() {
+        require(4);
+        auto value = VaultSnapshot_readUInt32(data.data() + position);
+        position += 4;
+        return value;
+    }
+
+    std::string readString() {
+        auto length = readUInt32();
+        require(length);
+        std::string value(data.begin() + position, data.begin() + position + length);
+        position += length;
+        return value;
+    }
+
+private:
+    void require(size_t length) const {
+        if (length > data.size() - position) {
+            throw std::runtime_error("Truncated snapshot record");
+        }
+    }
+
+    const Botan::secure_vector<Botan::byte> &data;
+    size_t position = 0;
+};
+
+std::vector<Botan::byte> VaultSnapshot_serializeHeader(const VaultSnapshot_Header &header) {
+    std::vector<Botan::byte> output(VaultSnapshot_magic, VaultSnapshot_magic + sizeof(VaultSnapshot_magic));
+
+    VaultSnapshot_appendUInt32(output, header.version);
+    VaultSnapshot_appendUInt32(output, header.entryCount);
+    output.insert(output.end(), header.noncePrefix, header.noncePrefix + VaultSnapshot_noncePrefixSize);
+    VaultSnapshot_appendUInt64(output, header.entryTableOffset);
+    VaultSnapshot_appendUInt64(output, header.urlIndexOffset);
+    VaultSnapshot_appendUInt64(output, header.urlIndexLength);
+    output.insert(output.end(), header.identity, header.identity + VaultSnapshot_identitySize);
+
+    output.resize(VaultSnapshot_headerSize, 0);
+
+    return output;
+}
+
+std::vector<Botan::byte> VaultSnapshot_recordNonce(
+        const Botan::byte *noncePrefix,
+        uint64_t recordNumber
+) {
+    std::vector<Botan::byte> nonce(noncePrefix, noncePrefix + VaultSnapshot_noncePrefixSize);
+    VaultSnapshot_appendUInt64(nonce, recordNumber);
+    return nonce;
+}
+
+std::vector<Botan::byte> VaultSnapshot_recordAssociatedData(
+        const Botan::byte *header,
+        uint64_t recordNumber
+) {
+    std::vector<Botan::byte> associatedData(header, header + VaultSnapshot_headerSize);
+    VaultSnapshot_appendUInt64(associatedData, recordNumber);
+    return associatedData;
+}
+
+void VaultSnapshot_sealRecord(
+        const Botan::secure_vector<Botan::byte> &key,
+        const std::vector<Botan::byte> &header,
+        const Botan::byte *noncePrefix,
+        uint64_t recordNumber,
+        Botan::secure_vector<Botan::byte> &record
+) {
+    auto cipher = Botan::AEAD_Mode::create_or_throw(VaultSnapshot_cipher, Botan::ENCRYPTION);
+    cipher->set_key(key.data(), key.size());
+
+    auto associatedData = VaultSnapshot_recordAssociatedData(header.data(), recordNumber);
+    cipher->set_associated_data(associatedData.data(), associatedData.size());
+
+    auto nonce = VaultSnapshot_recordNonce(noncePrefix, recordNumber);
+    cipher->start(nonce.data(), nonce.size());
+    cipher->finish(record);
+}
+
+void VaultSnapshot_writeFile(const std::string &path, const std::vector<Botan::byte> &contents) {
+    std::string temporaryPath = path + ".tmp";
+
+    int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create snapshot file");
+    }
+
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t result = ::write(fd, contents.data() + written, contents.size() - written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            close(fd);
+            unlink(temporaryPath.c_str());
+            throw std::runtime_error("Failed to write snapshot file");
+        }
+
+        written += result;
+    }
+
+    if (fsync(fd) == -1 || close(fd) == -1) {
+        unlink(temporaryPath.c_str());
+        throw std::runtime_error("Failed to flush snapshot file");
+    }
+
+    // Readers either see the previous snapshot or the complete new one
+    if (rename(temporaryPath.c_str(), path.c_str()) == -1) {
+        unlink(temporaryPath.c_str());
+        throw std::runtime_error("Failed to replace snapshot file");
+    }
+}
+
+void VaultSnapshot::write(
+        const std::string &path,
+        const Botan::secure_vector<Botan::byte> &key,
+        const Botan::secure_vector<Botan::byte> &identity,
+        const std::vector<SnapshotEntry> &entries
+) {
+    if (identity.size() != VaultSnapshot_identitySize) {
+        throw std::invalid_argument("Invalid snapshot identity");
+    }
+
+    VaultSnapshot_Header header{};
+    header.version = VaultSnapshot_version;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    std::copy(identity.begin(), identity.end(), header.identity);
+
+    // A fresh nonce prefix per file keeps the nonces unique even if the
+    // caller writes several snapshots with the same key.
+    Botan::AutoSeeded_RNG rng;
+    rng.randomize(header.noncePrefix, VaultSnapshot_noncePrefixSize);
+
+    std::vector<Botan::secure_vector<Botan::byte>> records;
+    records.reserve(entries.size() + 1);
+
+    Botan::secure_vector<Botan::byte> urlIndex;
+    for (uint32_t entryIndex = 0; entryIndex < entries.size(); entryIndex++) {
+        const SnapshotEntry &entry = entries[entryIndex];
+
+        Botan::secure_vector<Botan::byte> record;
+        VaultSnapshot_appendString(record, entry.uuid);
+        for (const auto &field: entry.fields) {
+            VaultSnapshot_appendString(record, field);
+        }
+        records.push_back(std::move(record));
+
+        for (const auto &url: entry.urls) {
+            VaultSnapshot_appendUInt32(urlIndex, entryIndex);
+            VaultSnapshot_appendString(urlIndex, url);
+        }
+    }
+    records.push_back(std::move(urlIndex));
+
+    // The header is authenticated with every record, so the final offsets are
+    // needed before anything can be sealed. Each record grows by one tag.
+    size_t tagSize = Botan::AEAD_Mode::create_or_throw(
+            VaultSnapshot_cipher,
+            Botan::ENCRYPTION
+    )->tag_size();
+
+    header.entryTableOffset = VaultSnapshot_headerSize;
+    header.urlIndexOffset = header.entryTableOffset + entries.size() * VaultSnapshot_tableRowSize;
+    header.urlIndexLength = records.back().size() + tagSize;
+
+    auto headerBytes = VaultSnapshot_serializeHeader(header);
+
+    std::vector<Botan::byte> table;
+    std::vector<Botan::byte> body;
+    uint64_t recordOffset = header.urlIndexOffset + header.urlIndexLength;
+
+    for (uint32_t entryIndex = 0; entryIndex < entries.size(); entryIndex++) {
+        auto &record = records[entryIndex];
+        VaultSnapshot_sealRecord(key, headerBytes, header.noncePrefix, entryIndex, record);
+
+        VaultSnapshot_appendUInt64(table, recordOffset);
+        VaultSnapshot_appendUInt64(table, record.size());
+
+        body.insert(body.end(), record.begin(), record.end());
+        recordOffset += record.size();
+    }
+
+    auto &urlRecord = records.back();
+    VaultSnapshot_sealRecord(key, headerBytes, header.noncePrefix, header.entryCount, urlRecord);
+
+    std::vector<Botan::byte> contents;
+    contents.reserve(recordOffset);
+    contents.insert(contents.end(), headerBytes.begin(), headerBytes.end());
+    contents.insert(contents.end(), table.begin(), table.end());
+    contents.insert(contents.end(), urlRecord.begin(), urlRecord.end());
+    contents.insert(contents.end(), body.begin(), body.end());
+
+    VaultSnapshot_writeFile(path, contents);
+}
+
+VaultSnapshot::VaultSnapshot(
+        const std::string &path,
+        const Botan::secure_vector<Botan::byte> &key,
+        const Botan::secure_vector<Botan::byte> &identity
+) : key(key) {
+    if (identity.size() != VaultSnapshot_identitySize) {
+        throw std::invalid_argument("Invalid snapshot identity");
+    }
+
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open snapshot file");
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) == -1 || fileStat.st_size < (off_t) VaultSnapshot_headerSize) {
+        close(fd);
+        throw std::runtime_error("Invalid snapshot file");
+    }
+
+    mappingSize = static_cast<size_t>(fileStat.st_size);
+    void *fileMapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (fileMapping == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map snapshot file");
+    }
+    mapping = static_cast<const Botan::byte *>(fileMapping);
+
+    try {
+        if (memcmp(mapping, VaultSnapshot_magic, sizeof(VaultSnapshot_magic)) != 0
+            || VaultSnapshot_readUInt32(mapping + 8) != VaultSnapshot_version) {
+            throw std::runtime_error("Unsupported snapshot file");
+        }
+
+        // A snapshot of any other version of the database, including one saved
+        // with a different master key, is stale
+        if (memcmp(mapping + 56, identity.data(), VaultSnapshot_identitySize) != 0) {
+            throw std::runtime_error("Snapshot is from a different database");
+        }
+
+        entryCount = VaultSnapshot_readUInt32(mapping + 12);
+        uint64_t entryTableOffset = VaultSnapshot_readUInt64(mapping + 32);
+        uint64_t urlIndexOffset = VaultSnapshot_readUInt64(mapping + 40);
+        uint64_t urlIndexLength = VaultSnapshot_readUInt64(mapping + 48);
+
+        if (entryTableOffset > mappingSize
+            || (mappingSize - entryTableOffset) / VaultSnapshot_tableRowSize < entryCount) {
+            throw std::runtime_error("Invalid snapshot entry table");
+        }
+
+        // Only the URL index is opened up front, this also confirms the key
+        auto urls = openRecord(entryCount, urlIndexOffset, urlIndexLength);
+        VaultSnapshot_RecordReader reader(urls);
+
+        while (!reader.atEnd()) {
+            auto entryIndex = reader.readUInt32();
+            if (entryIndex >= entryCount) {
+                throw std::runtime_error("Invalid snapshot URL index");
+            }
+
+            urlIndex.push_back({entryIndex, DomainMatcher_normalize(reader.readString())});
+        }
+    } catch (...) {
+        munmap(const_cast<Botan::byte *>(mapping), mappingSize);
+        close(fd);
+        throw;
+    }
+}
+
+VaultSnapshot::~VaultSnapshot() {
+    munmap(const_cast<Botan::byte *>(mapping), mappingSize);
+    close(fd);
+}
+
+uint32_t VaultSnapshot::count() const {
+    return entryCount;
+}
+
+std::vector<uint32_t> VaultSnapshot::find(const std::string &query) const {
+    auto queryTarget = DomainMatcher_normalize(query);
+
+    std::vector<DomainMatch> bestMatches(entryCount, NoMatch);
+    for (const auto &url: urlIndex) {
+        auto match = DomainMatcher_match(queryTarget, url.target);
+        if (match > bestMatches[url.entryIndex]) {
+            bestMatches[url.entryIndex] = match;
+        }
+    }
+
+    std::vector<uint32_t> found;
+    for (uint32_t entryIndex = 0; entryIndex < entryCount; entryIndex++) {
+        if (bestMatches[entryIndex] != NoMatch) {
+            found.push_back(entryIndex);
+        }
+    }
+
+    std::stable_sort(found.begin(), found.end(), [&bestMatches](uint32_t a, uint32_t b) {
+        return bestMatches[a] > bestMatches[b];
+    });
+
+    return found;
+}
+
+std::vector<std::string> VaultSnapshot::read(uint32_t index) const {
+    if (index >= entryCount) {
+        throw std::out_of_range("Unknown snapshot entry");
+    }
+
+    const Botan::byte *row = mapping + VaultSnapshot_readUInt64(mapping + 32)
+                             + static_cast<size_t>(index) * VaultSnapshot_tableRowSize;
+
+    auto record = openRecord(
+            index,
+            VaultSnapshot_readUInt64(row),
+            VaultSnapshot_readUInt64(row + 8)
+    );
+    VaultSnapshot_RecordReader reader(record);
+
+    std::vector<std::string> values;
+    while (!reader.atEnd()) {
+        values.push_back(reader.readString());
+    }
+
+    return values;
+}
+
+Botan::secure_vector<Botan::byte> VaultSnapshot::openRecord(
+        uint64_t recordNumber,
+        uint64_t offset,
+        uint64_t length
+) const {
+    if (offset > mappingSize || length > mappingSize - offset) {
+        throw std::runtime_error("Invalid snapshot record bounds");
+    }
+
+    auto cipher = Botan::AEAD_Mode::create_or_throw(VaultSnapshot_cipher, Botan::DECRYPTION);
+    cipher->set_key(key.data(), key.size());
+
+    auto associatedData = VaultSnapshot_recordAssociatedData(mapping, recordNumber);
+    cipher->set_associated_data(associatedData.data(), associatedData.size());
+
+    auto nonce = VaultSnapshot_recordNonce(mapping + 16, recordNumber);
+    cipher->start(nonce.data(), nonce.size());
+
+    Botan::secure_vector<Botan::byte> record(mapping + offset, mapping + offset + length);
+    cipher->finish(record);
+
+    return record;
+}
@@ -0,0 +1,76 @@
+#ifndef KEEPASSRN_VAULTSNAPSHOT_H
+#define KEEPASSRN_VAULTSNAPSHOT_H
+
+#include <botan/secmem.h>
+#include <botan/types.h>
+#include <string>
+#include <vector>
+
+#include "DomainMatcher.h"
+
+struct SnapshotEntry {
+    std::string uuid;
+    std::vector<std::string> fields;
+    std::vector<std::string> urls;
+};
+
+/**
+ * A compact, read-only copy of an unlocked database used to answer lookups
+ * without going through the full KDBX pipeline.
+ *
+ * The file holds a plaintext header and entry table, followed by an encrypted
+ * URL index and one encrypted record per entry. Every record is sealed with
+ * XChaCha20Poly1305 using the header and its record number as associated data,
+ * so the file is mapped as-is and records are only decrypted when read.
+ *
+ * The header also carries the identity of the database version it was taken
+ * from, a snapshot is only opened for that exact version.
+ */
+class VaultSnapshot {
+public:
+    static void write(
+            const std::string &path,
+            const Botan::secure_vector<Botan::byte> &key,
+            const Botan::secure_vector<Botan::byte> &identity,
+            const std::vector<SnapshotEntry> &entries
+    );
+
+    VaultSnapshot(
+            const std::string &path,
+            const Botan::secure_vector<Botan::byte> &key,
+            const Botan::secure_vector<Botan::byte> &identity
+    );
+
+    ~VaultSnapshot();
+
+    VaultSnapshot(const VaultSnapshot &) = delete;
+
+    VaultSnapshot &operator=(const VaultSnapshot &) = delete;
+
+    uint32_t count() const;
+
+    std::vector<uint32_t> find(const std::string &query) const;
+
+    std::vector<std::string> read(uint32_t index) const;
+
+private:
+    struct IndexedUrl {
+        uint32_t entryIndex;
+        DomainTarget target;
+    };
+
+    Botan::secure_vector<Botan::byte> openRecord(
+            uint64_t recordNumber,
+            uint64_t offset,
+            uint64_t length
+    ) const;
+
+    int fd = -1;
+    const Botan::byte *mapping = nullptr;
+    size_t mappingSize = 0;
+    uint32_t entryCount = 0;
+    Botan::secure_vector<Botan::byte> key;
+    std::vector<IndexedUrl> urlIndex;
+};
+
+#endif //KEEPASSRN_VAULTSNAPSHOT_H
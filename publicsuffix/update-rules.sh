@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+set -e
+
+# Usage: update-rules.sh [path/to/public_suffix_list.dat]
+# Without an argument the current list is downloaded from publicsuffix.org.
+# Requires idn2 (GNU libidn2) to convert internationalized rules to punycode.
+
+if ! command -v idn2 > /dev/null; then
+  echo "idn2 is required to convert internationalized rules" >&2
+  exit 1
+fi
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+LIST_URL=https://publicsuffix.org/list/public_suffix_list.dat
+OUTPUT_PATH=$SCRIPT_DIR/../android/app/src/main/jni/helper/PublicSuffixRules.inc
+
+if [ -n "$1" ]; then
+  echo "Reading $1"
+  LIST=$(cat "$1")
+else
+  echo "Downloading $LIST_URL"
+  LIST=$(curl --silent --fail "$LIST_URL")
+fi
+
+{
+  echo "// Generated by publicsuffix/update-rules.sh from the Public Suffix List"
+  echo "// ($LIST_URL)."
+  echo "//"
+  echo "// Each entry is a single rule exactly as written in the list, including the"
+  echo "// \"*.\" wildcard and \"!\" exception prefixes."
+  echo ""
+
+  # The matcher converts hosts to punycode before looking them up, so
+  # internationalized rules are written in their punycode form too.
+  echo "$LIST" |
+    awk '
+      /^\/\/ ===(BEGIN|END) (ICANN|PRIVATE) DOMAINS===/ { print; next }
+      /^\/\// || /^[[:space:]]*$/ { next }
+      { sub(/[[:space:]].*$/, ""); print }
+    ' |
+    while IFS= read -r RULE; do
+      if [[ $RULE == //* ]]; then
+        echo "$RULE"
+        continue
+      fi
+
+      if LC_ALL=C grep -q '[^ -~]' <<< "$RULE"; then
+        # idn2 rejects the wildcard and exception prefixes
+        PREFIX=${RULE%%[^*.!]*}
+        RULE=$PREFIX$(idn2 "${RULE#"$PREFIX"}")
+      fi
+
+      echo "\"$RULE\","
+    done
+} > "$OUTPUT_PATH"
+
+echo "Wrote $(grep -c '^"' "$OUTPUT_PATH") rules to $OUTPUT_PATH"
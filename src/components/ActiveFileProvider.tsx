@@ -9,6 +9,8 @@ import React, {
   useState,
 } from 'react';
 
+import VaultSnapshot from '../lib/format/VaultSnapshot';
+
 export enum KeyType {
   Password,
   File,
@@ -67,6 +69,15 @@ export interface ActiveFileState {
   setFile: (file: LoadedFile, keys: KeySetting[]) => Promise<void>;
 }
 
+// The snapshot belongs to one file unlocked with one set of keys
+function deleteSnapshot(file: ActiveFile | undefined) {
+  if (file) {
+    VaultSnapshot.delete(file.file.uri).catch(error =>
+      console.warn('Failed to delete snapshot', error),
+    );
+  }
+}
+
 const ActiveFileContext = createContext<ActiveFileState>({
   activeFile: undefined,
   addKey: () => Promise.resolve(),
@@ -82,16 +93,23 @@ const ActiveFileProvider: FunctionComponent<PropsWithChildren> = ({
   const [activeFile, setActiveFile] = useState<ActiveFile>();
   const [loading, setLoading] = useState<boolean>(true);
 
-  const setFile = useCallback(async (file: LoadedFile, keys: KeySetting[]) => {
-    const updatedFile: ActiveFile = {file, keys};
-    await AsyncStorage.setItem('loaded-file', JSON.stringify(updatedFile));
-    setActiveFile(updatedFile);
-  }, []);
+  const setFile = useCallback(
+    async (file: LoadedFile, keys: KeySetting[]) => {
+      deleteSnapshot(activeFile);
+
+      const updatedFile: ActiveFile = {file, keys};
+      await AsyncStorage.setItem('loaded-file', JSON.stringify(updatedFile));
+      setActiveFile(updatedFile);
+    },
+    [activeFile],
+  );
 
   const clearFile = useCallback(async () => {
+    deleteSnapshot(activeFile);
+
     await AsyncStorage.removeItem('loaded-file');
     setActiveFile(undefined);
-  }, []);
+  }, [activeFile]);
 
   const addKey = useCallback(
     async (key: KeySetting) => {
@@ -39,8 +39,13 @@ const LockStateProvider: FunctionComponent<PropsWithChildren> = ({
   }, []);
 
   const lockDatabase = useCallback(() => {
+    database
+      ?.getAttachmentStore()
+      ?.destroy()
+      .catch(error => console.warn('Failed to release attachments', error));
+
     setDatabase(undefined);
-  }, []);
+  }, [database]);
 
   return (
     <LockStateContext.Provider
@@ -0,0 +1,14 @@
+interface Attachment {
+  id: number;
+  size: number;
+}
+
+export interface AttachmentStore {
+  add(data: Uint8Array): Promise<Attachment>;
+
+  write(attachment: Attachment, uri: string): Promise<void>;
+
+  destroy(): Promise<void>;
+}
+
+export default Attachment;
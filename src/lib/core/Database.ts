@@ -2,7 +2,9 @@ import Kdf from '../crypto/kdf/Kdf';
 import {VariantFieldMap} from '../format/Keepass2';
 import CompositeKey from '../keys/CompositeKey';
 import PasswordKey from '../keys/PasswordKey';
+import {AttachmentStore} from './Attachment';
 import DatabaseData from './DatabaseData';
+import Entry, {DeferredHistory} from './Entry';
 import Group from './Group';
 import Metadata from './Metadata';
 import {Uuid} from './types';
@@ -30,6 +32,8 @@ export interface CustomDataItem {
   lastModified?: Date;
 }
 
+export type HistoryLoader = (history: DeferredHistory) => Promise<Entry[]>;
+
 export class Database {
   readonly metadata: Metadata;
   readonly data: DatabaseData;
@@ -37,8 +41,11 @@ export class Database {
   public rootGroup?: Group;
   public deletedObjects: DeletedObject[] = [];
 
+  private attachmentStore?: AttachmentStore;
   private cipher?: string;
   private formatVersion?: number;
+  private headerHash?: Uint8Array;
+  private historyLoader?: HistoryLoader;
 
   constructor(key: CompositeKey) {
     this.data = new DatabaseData(key);
@@ -56,6 +63,40 @@ export class Database {
     return this.cipher;
   }
 
+  // SHA-256 of the outer header, it changes every time the file is saved
+  setHeaderHash(hash: Uint8Array) {
+    this.headerHash = hash;
+  }
+
+  getHeaderHash(): Uint8Array | undefined {
+    return this.headerHash;
+  }
+
+  setAttachmentStore(store: AttachmentStore) {
+    this.attachmentStore = store;
+  }
+
+  getAttachmentStore(): AttachmentStore | undefined {
+    return this.attachmentStore;
+  }
+
+  setHistoryLoader(loader: HistoryLoader) {
+    this.historyLoader = loader;
+  }
+
+  async loadHistory(entry: Entry): Promise<Entry[]> {
+    if (entry.deferredHistory) {
+      if (!this.historyLoader) {
+        throw new Error('No history loader set');
+      }
+
+      entry.history = await this.historyLoader(entry.deferredHistory);
+      delete entry.deferredHistory;
+    }
+
+    return entry.history;
+  }
+
   setCompressionAlgorithm(type: CompressionAlgorithm) {
     this.data.compressionAlgorithm = type;
   }
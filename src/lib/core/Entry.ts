@@ -1,3 +1,4 @@
+import Attachment from './Attachment';
 import {CustomDataItem} from './Database';
 import TimeInfo from './TimeInfo';
 import {Uuid} from './types';
@@ -7,8 +8,21 @@ export interface AutoTypeAssociation {
   sequence?: string;
 }
 
+/**
+ * The byte range of an entry's `<History>` element within the decrypted XML,
+ * kept unparsed until it is needed. Protected values inside it are still
+ * encrypted, so the inner random stream position it starts at is recorded
+ * alongside it.
+ */
+export interface DeferredHistory {
+  count: number;
+  streamOffset: number;
+  start: number;
+  end: number;
+}
+
 interface Entry {
-  attachments: Record<string, Uint8Array>;
+  attachments: Record<string, Attachment>;
   attributes: Record<string, string>;
   autoTypeAssociations: AutoTypeAssociation[];
   autoTypeEnabled?: boolean;
@@ -17,6 +31,7 @@ interface Entry {
   customData: Record<string, CustomDataItem>;
   customIcon?: Uuid;
   defaultAutoTypeSequence?: string;
+  deferredHistory?: DeferredHistory;
   foregroundColor?: string;
   history: Entry[];
   iconNumber?: number;
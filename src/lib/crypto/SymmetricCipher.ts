@@ -28,6 +28,9 @@ export interface Cipher {
 
   finish(data: Uint8Array): Promise<Uint8Array>;
 
+  // Moves a stream cipher to an absolute keystream position
+  seek(position: number): Promise<void>;
+
   destroy(): Promise<void>;
 }
 
@@ -44,6 +47,7 @@ export default class SymmetricCipher {
 
     switch (mode) {
       case SymmetricCipherMode.ChaCha20:
+      case SymmetricCipherMode.Salsa20:
       case SymmetricCipherMode.Twofish_CBC:
       case SymmetricCipherMode.Aes256_CBC: {
         return await KpHelperModule.createCipher(mode, direction, key, iv);
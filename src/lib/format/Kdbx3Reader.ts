@@ -0,0 +1,229 @@
+import Attachment from '../core/Attachment';
+import {CompressionAlgorithm, Database} from '../core/Database';
+import CryptoHash, {CryptoHashAlgorithm} from '../crypto/CryptoHash';
+import AesKdf from '../crypto/kdf/AesKdf';
+import SymmetricCipher, {SymmetricCipherMode} from '../crypto/SymmetricCipher';
+import CompositeKey from '../keys/CompositeKey';
+import KpHelperModule from '../utilities/KpHelperModule';
+import Uint8ArrayCursorReader from '../utilities/Uint8ArrayCursorReader';
+import Uint8ArrayReader from '../utilities/Uint8ArrayReader';
+import {gunzip} from '../utilities/zlib';
+import KdbxReader from './KdbxReader';
+import KdbxXmlReader from './KdbxXmlReader';
+import {
+  FILE_VERSION_3,
+  FILE_VERSION_3_1,
+  FILE_VERSION_CRITICAL_MASK,
+  HeaderFieldId,
+  isHeaderFieldId,
+} from './Keepass2';
+import KeePass2RandomStream from './KeePass2RandomStream';
+
+export default class Kdbx3Reader extends KdbxReader {
+  private kdf?: AesKdf;
+  private streamStartBytes?: Uint8Array;
+
+  protected readHeaderField(
+    reader: Uint8ArrayCursorReader,
+    database: Database,
+  ): boolean {
+    const fieldId = reader.readInt8();
+    if (!isHeaderFieldId(fieldId)) {
+      throw new Error('Invalid header id size');
+    }
+
+    const fieldLen = reader.readUInt16LE();
+
+    let fieldData: Uint8Array = new Uint8Array(0);
+    if (fieldLen) {
+      fieldData = reader.readBytes(fieldLen);
+      if (fieldData.byteLength !== fieldLen) {
+        throw new Error(
+          `Invalid header data length: field ${HeaderFieldId[fieldId]}, ${fieldLen} expected, ${fieldData.byteLength} found`,
+        );
+      }
+    }
+
+    switch (fieldId) {
+      case HeaderFieldId.EndOfHeader:
+        return false;
+
+      case HeaderFieldId.CipherID:
+        this.setCipher(fieldData, database);
+        break;
+
+      case HeaderFieldId.CompressionFlags:
+        this.setCompressionFlags(fieldData, database);
+        break;
+
+      case HeaderFieldId.MasterSeed:
+        this.setMasterSeed(fieldData);
+        break;
+
+      case HeaderFieldId.TransformSeed:
+        if (!this.getKdf(database).setSeed(fieldData)) {
+          throw new Error('Invalid transform seed size');
+        }
+        break;
+
+      case HeaderFieldId.TransformRounds:
+        if (fieldData.byteLength !== 8) {
+          throw new Error('Invalid transform rounds size');
+        }
+        if (
+          !this.getKdf(database).setRounds(
+            Uint8ArrayReader.toUInt64LE(fieldData),
+          )
+        ) {
+          throw new Error('Invalid transform rounds');
+        }
+        break;
+
+      case HeaderFieldId.EncryptionIV:
+        this.setEncryptionIV(fieldData);
+        break;
+
+      case HeaderFieldId.ProtectedStreamKey:
+        this.setProtectedStreamKey(fieldData);
+        break;
+
+      case HeaderFieldId.StreamStartBytes:
+        if (fieldData.byteLength !== 32) {
+          throw new Error('Invalid start bytes size');
+        }
+        this.streamStartBytes = fieldData;
+        break;
+
+      case HeaderFieldId.InnerRandomStreamID:
+        this.setSymmetricCipherModeFromInnerRandomStreamId(fieldData);
+        break;
+
+      case HeaderFieldId.KdfParameters:
+      case HeaderFieldId.PublicCustomData:
+        throw new Error('KDBX4 header fields found in KDBX3 file.');
+
+      default:
+        console.warn(`Unknown header field read: id=${fieldId}`);
+        break;
+    }
+
+    return true;
+  }
+
+  protected async readVersionDatabase(
+    reader: Uint8ArrayCursorReader,
+    headerData: Uint8Array,
+    key: CompositeKey,
+    database: Database,
+  ): Promise<Database> {
+    if (
+      // eslint-disable-next-line no-bitwise
+      (database.getFormatVersion() & FILE_VERSION_CRITICAL_MASK) !==
+      FILE_VERSION_3
+    ) {
+      throw new Error('Unexpected file version');
+    }
+
+    if (
+      !this.getMasterSeed() ||
+      !this.getEncryptionIV() ||
+      !this.streamStartBytes ||
+      !this.kdf ||
+      !database.getCipher()
+    ) {
+      throw new Error('missing database headers');
+    }
+
+    if (!(await database.setKey(key))) {
+      throw new Error('Unable to calculate database key');
+    }
+
+    const finalKey = await CryptoHash.hash(
+      [this.getMasterSeed(), await database.getTransformedDatabaseKey()],
+      CryptoHashAlgorithm.Sha256,
+    );
+
+    const mode = SymmetricCipher.cipherUuidToMode(database.getCipher());
+    if (mode === SymmetricCipherMode.InvalidMode) {
+      throw new Error(`Unknown cipher ${database.getCipher()}`);
+    }
+
+    // Decryption, the stream start bytes check and the hashed block stream
+    // are all handled in a single native pass over the payload.
+    const processedBytes = await KpHelperModule.decryptKdbx3Payload(
+      mode,
+      finalKey,
+      this.getEncryptionIV(),
+      this.streamStartBytes,
+      reader.slice(),
+    );
+
+    const isCompressed =
+      database.getCompressionAlgorithm() ===
+      CompressionAlgorithm.CompressionGZip;
+
+    const buffer = isCompressed ? await gunzip(processedBytes) : processedBytes;
+
+    const binaryPool: Record<string, Attachment> = {};
+    const randomStream = await KeePass2RandomStream.create(
+      this.getSymmetricCipherMode(),
+      this.getProtectedStreamKey(),
+    );
+
+    const xmlReader = new KdbxXmlReader(
+      FILE_VERSION_3_1,
+      binaryPool,
+      randomStream,
+      this.options.deferHistory,
+    );
+
+    await this.readWithAttachmentStore(
+      database,
+      async () => {
+        try {
+          await xmlReader.readDatabase(buffer, database);
+        } finally {
+          // The native stream holds the protected stream key
+          await randomStream.destroy();
+        }
+
+        const headerHash = database.metadata.headerHash;
+        if (
+          headerHash &&
+          !Uint8ArrayReader.equals(
+            headerHash,
+            await CryptoHash.hash(headerData, CryptoHashAlgorithm.Sha256),
+          )
+        ) {
+          throw new Error("Header doesn't match hash");
+        }
+      },
+      () => xmlReader.getAttachmentStore(),
+    );
+
+    if (this.options.deferHistory) {
+      database.setHistoryLoader(
+        KdbxXmlReader.createHistoryLoader(
+          FILE_VERSION_3_1,
+          buffer,
+          binaryPool,
+          this.getSymmetricCipherMode(),
+          this.getProtectedStreamKey(),
+        ),
+      );
+    }
+
+    return database;
+  }
+
+  private getKdf(database: Database): AesKdf {
+    if (!this.kdf) {
+      // KDBX 3.1 has no KDF parameters, the transform seed and rounds are
+      // separate header fields for the legacy AES-KDF.
+      this.kdf = new AesKdf(true);
+      database.setKdf(this.kdf);
+    }
+
+    return this.kdf;
+  }
+}
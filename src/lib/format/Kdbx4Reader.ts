@@ -1,3 +1,4 @@
+import Attachment, {AttachmentStore} from '../core/Attachment';
 import {CompressionAlgorithm, Database} from '../core/Database';
 import CryptoHash, {CryptoHashAlgorithm} from '../crypto/CryptoHash';
 import SymmetricCipher, {
@@ -6,6 +7,7 @@ import SymmetricCipher, {
 } from '../crypto/SymmetricCipher';
 import CompositeKey from '../keys/CompositeKey';
 import HmacBlockStream, {UINT64_MAX} from '../streams/HmacBlockStream';
+import KpHelperModule from '../utilities/KpHelperModule';
 import Uint8ArrayCursorReader from '../utilities/Uint8ArrayCursorReader';
 import Uint8ArrayReader from '../utilities/Uint8ArrayReader';
 import {gunzip} from '../utilities/zlib';
@@ -29,7 +31,8 @@ import {
 import KeePass2RandomStream from './KeePass2RandomStream';
 
 export default class Kdbx4Reader extends KdbxReader {
-  private binaryPool: Record<string, Uint8Array> = {};
+  private binaryPool: Record<string, Attachment> = {};
+  private attachmentStore?: AttachmentStore;
 
   protected readHeaderField(
     reader: Uint8ArrayCursorReader,
@@ -226,6 +229,7 @@ export default class Kdbx4Reader extends KdbxReader {
     database: Database,
   ): Promise<Database> {
     this.binaryPool = {};
+    this.attachmentStore = undefined;
 
     if (
       // eslint-disable-next-line no-bitwise
@@ -325,30 +329,54 @@ export default class Kdbx4Reader extends KdbxReader {
       new Uint8ArrayReader(buffer),
     );
 
-    while (this.readInnerHeaderField(bufferReader)) {
-      //
-    }
+    await this.readWithAttachmentStore(
+      database,
+      async () => {
+        while (await this.readInnerHeaderField(bufferReader)) {
+          //
+        }
 
-    const randomStream = await KeePass2RandomStream.create(
-      this.getSymmetricCipherMode(),
-      this.getProtectedStreamKey(),
-    );
+        const randomStream = await KeePass2RandomStream.create(
+          this.getSymmetricCipherMode(),
+          this.getProtectedStreamKey(),
+        );
 
-    const xmlReader = new KdbxXmlReader(
-      FILE_VERSION_4,
-      this.binaryPool,
-      randomStream,
-    );
-    const remaining = bufferReader.slice();
+        const xmlReader = new KdbxXmlReader(
+          FILE_VERSION_4,
+          this.binaryPool,
+          randomStream,
+          this.options.deferHistory,
+        );
+        const remaining = bufferReader.slice();
 
-    await xmlReader.readDatabase(remaining, database);
+        try {
+          await xmlReader.readDatabase(remaining, database);
+        } finally {
+          // The native stream holds the protected stream key
+          await randomStream.destroy();
+        }
 
-    await randomStream.destroy();
+        if (this.options.deferHistory) {
+          database.setHistoryLoader(
+            KdbxXmlReader.createHistoryLoader(
+              FILE_VERSION_4,
+              remaining,
+              this.binaryPool,
+              this.getSymmetricCipherMode(),
+              this.getProtectedStreamKey(),
+            ),
+          );
+        }
+      },
+      () => this.attachmentStore,
+    );
 
     return database;
   }
 
-  protected readInnerHeaderField(reader: Uint8ArrayCursorReader): boolean {
+  protected async readInnerHeaderField(
+    reader: Uint8ArrayCursorReader,
+  ): Promise<boolean> {
     const fieldId = reader.readInt8();
     if (!isInnerHeaderFieldId(fieldId)) {
       throw new Error('Invalid inner header id size');
@@ -387,8 +415,11 @@ export default class Kdbx4Reader extends KdbxReader {
         if (fieldLen < 1) {
           throw new Error('Invalid inner header binary size');
         }
+        if (!this.attachmentStore) {
+          this.attachmentStore = await KpHelperModule.createAttachmentStore();
+        }
         this.binaryPool[`${Object.keys(this.binaryPool).length}`] =
-          fieldData.subarray(1);
+          await this.attachmentStore.add(fieldData.subarray(1));
         break;
       }
     }
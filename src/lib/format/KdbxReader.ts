@@ -1,4 +1,6 @@
+import {AttachmentStore} from '../core/Attachment';
 import {Database, isCompressionAlgorithm} from '../core/Database';
+import CryptoHash, {CryptoHashAlgorithm} from '../crypto/CryptoHash';
 import SymmetricCipher, {SymmetricCipherMode} from '../crypto/SymmetricCipher';
 import CompositeKey from '../keys/CompositeKey';
 import {UUID_SIZE} from '../utilities/sizes';
@@ -7,6 +9,11 @@ import Uint8ArrayReader from '../utilities/Uint8ArrayReader';
 import {stringifyUuid} from '../utilities/uuid';
 import {isProtectedStreamAlgo, ProtectedStreamAlgo} from './Keepass2';
 
+export interface KdbxReaderOptions {
+  // Leave each entry's history unparsed until Database.loadHistory is called
+  deferHistory?: boolean;
+}
+
 export default abstract class KdbxReader {
   private masterSeed?: Uint8Array;
   private encryptionIV?: Uint8Array;
@@ -14,6 +21,8 @@ export default abstract class KdbxReader {
   private symmetricCipherMode?: SymmetricCipherMode;
   private streamKey?: Uint8Array;
 
+  constructor(protected readonly options: KdbxReaderOptions = {}) {}
+
   async readDatabase(bytes: Uint8Array, key: CompositeKey): Promise<Database> {
     const reader = new Uint8ArrayCursorReader(new Uint8ArrayReader(bytes));
 
@@ -31,6 +40,9 @@ export default abstract class KdbxReader {
     }
 
     const headerData = reader.processed();
+    database.setHeaderHash(
+      await CryptoHash.hash(headerData, CryptoHashAlgorithm.Sha256),
+    );
 
     return await this.readVersionDatabase(reader, headerData, key, database);
   }
@@ -47,6 +59,32 @@ export default abstract class KdbxReader {
     database: Database,
   ): Promise<Database>;
 
+  /**
+   * Runs `read` and hands the attachment store it filled over to the database.
+   * The attachments live outside the JS heap, so they are released here if
+   * the read fails instead.
+   */
+  protected async readWithAttachmentStore(
+    database: Database,
+    read: () => Promise<void>,
+    getAttachmentStore: () => AttachmentStore | undefined,
+  ): Promise<void> {
+    try {
+      await read();
+    } catch (e) {
+      // A failed cleanup must not hide why the read failed
+      await getAttachmentStore()
+        ?.destroy()
+        .catch(() => undefined);
+      throw e;
+    }
+
+    const attachmentStore = getAttachmentStore();
+    if (attachmentStore) {
+      database.setAttachmentStore(attachmentStore);
+    }
+  }
+
   private static readMagicNumbers(reader: Uint8ArrayCursorReader) {
     const signatureOne = reader.readUInt32LE();
     const signatureTwo = reader.readUInt32LE();
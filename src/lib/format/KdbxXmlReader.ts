@@ -1,28 +1,94 @@
-import {CustomDataItem, Database, DeletedObject} from '../core/Database';
-import Entry, {AutoTypeAssociation} from '../core/Entry';
+import {byteLength} from 'base64-js';
+
+import Attachment, {AttachmentStore} from '../core/Attachment';
+import {
+  CustomDataItem,
+  Database,
+  DeletedObject,
+  HistoryLoader,
+} from '../core/Database';
+import Entry, {AutoTypeAssociation, DeferredHistory} from '../core/Entry';
 import Group, {TriState} from '../core/Group';
 import Icon from '../core/Icon';
 import TimeInfo from '../core/TimeInfo';
 import {Uuid} from '../core/types';
-import {Cipher} from '../crypto/SymmetricCipher';
+import {Cipher, SymmetricCipherMode} from '../crypto/SymmetricCipher';
+import KpHelperModule from '../utilities/KpHelperModule';
 import {UUID_SIZE} from '../utilities/sizes';
 import Uint8ArrayReader from '../utilities/Uint8ArrayReader';
 import Uint8ArrayWriter from '../utilities/Uint8ArrayWriter';
 import {stringifyUuid} from '../utilities/uuid';
 import {XmlElement, XmlReader} from '../utilities/XmlReader';
-import {FILE_VERSION_4} from './Keepass2';
+import {gunzip} from '../utilities/zlib';
+import {FILE_VERSION_3_1, FILE_VERSION_4} from './Keepass2';
+import KeePass2RandomStream from './KeePass2RandomStream';
 
 export default class KdbxXmlReader {
+  private attachmentStore?: AttachmentStore;
+  private streamOffset: number = 0;
+
   constructor(
     private readonly version: number,
-    private readonly binaryPool: Record<string, Uint8Array>,
+    private readonly binaryPool: Record<string, Attachment>,
     private readonly randomStream: Cipher,
+    private readonly deferHistory: boolean = false,
   ) {
-    if (version !== FILE_VERSION_4) {
+    if (version !== FILE_VERSION_3_1 && version !== FILE_VERSION_4) {
       throw new Error('Unsupported file version');
     }
   }
 
+  /**
+   * The store holding attachments read from the KDBX 3.1 Meta/Binaries
+   * element, the caller takes ownership of it once reading finishes.
+   */
+  getAttachmentStore(): AttachmentStore | undefined {
+    return this.attachmentStore;
+  }
+
+  static createHistoryLoader(
+    version: number,
+    data: Uint8Array,
+    binaryPool: Record<string, Attachment>,
+    streamMode: SymmetricCipherMode,
+    streamKey: Uint8Array,
+  ): HistoryLoader {
+    return async history => {
+      const randomStream = await KeePass2RandomStream.create(
+        streamMode,
+        streamKey,
+      );
+
+      try {
+        const reader = new KdbxXmlReader(version, binaryPool, randomStream);
+        return await reader.readHistory(data, history);
+      } finally {
+        await randomStream.destroy();
+      }
+    };
+  }
+
+  async readHistory(
+    data: Uint8Array,
+    history: DeferredHistory,
+  ): Promise<Entry[]> {
+    // The random stream starts from the beginning, so it needs to be moved
+    // past everything decrypted before the history element first.
+    await this.seekRandomStream(history.streamOffset);
+
+    const xml = Uint8ArrayReader.toString(
+      data.subarray(history.start, history.end),
+    );
+    const entries = await this.parseHistoryItems(new XmlReader(xml));
+    if (entries.length !== history.count) {
+      throw new Error(
+        `Expected ${history.count} history entries, found ${entries.length}`,
+      );
+    }
+
+    return entries;
+  }
+
   async readDatabase(data: Uint8Array, database: Database): Promise<void> {
     const dataAsString = Uint8ArrayReader.toString(data);
     const reader = new XmlReader(dataAsString);
@@ -154,7 +220,8 @@ export default class KdbxXmlReader {
             KdbxXmlReader.readUnsignedNumber(reader);
           break;
         case 'Binaries':
-          throw new Error('"Binaries" not implemented');
+          await this.parseBinaries(reader.readFromCurrent());
+          break;
         case 'CustomData':
           database.metadata.customData = KdbxXmlReader.parseCustomData(
             reader.readFromCurrent(),
@@ -171,6 +238,41 @@ export default class KdbxXmlReader {
     }
   }
 
+  private async parseBinaries(reader: XmlReader) {
+    KdbxXmlReader.assertOpenedTagOf(reader, 'Binaries');
+
+    while (reader.readNextStartElement()) {
+      switch (reader.current.name) {
+        case 'Binary': {
+          const id = reader.current.attributes.ID;
+          if (id === undefined) {
+            throw new Error('Missing Binary ID');
+          }
+          if (this.binaryPool[id]) {
+            throw new Error(`Duplicate Binary ID "${id}"`);
+          }
+
+          const isCompressed =
+            reader.current.attributes.Compressed?.toLowerCase() === 'true';
+
+          let data = await this.readBinary(reader);
+          if (isCompressed) {
+            data = await gunzip(data);
+          }
+
+          if (!this.attachmentStore) {
+            this.attachmentStore = await KpHelperModule.createAttachmentStore();
+          }
+          this.binaryPool[id] = await this.attachmentStore.add(data);
+          break;
+        }
+        default:
+          reader.skipCurrentElement();
+          break;
+      }
+    }
+  }
+
   private static parseCustomData(
     reader: XmlReader,
   ): Record<string, CustomDataItem> {
@@ -497,9 +599,15 @@ export default class KdbxXmlReader {
           if (isInHistory) {
             throw new Error('History element in history entry');
           }
-          entry.history = await this.parseHistoryItems(
-            reader.readFromCurrent(),
-          );
+          if (this.deferHistory) {
+            entry.deferredHistory = await this.deferHistoryItems(
+              reader.readFromCurrent(),
+            );
+          } else {
+            entry.history = await this.parseHistoryItems(
+              reader.readFromCurrent(),
+            );
+          }
           break;
         case 'CustomData':
           entry.customData = KdbxXmlReader.parseCustomData(
@@ -576,6 +684,40 @@ export default class KdbxXmlReader {
     return history;
   }
 
+  private async deferHistoryItems(
+    reader: XmlReader,
+  ): Promise<DeferredHistory> {
+    KdbxXmlReader.assertOpenedTagOf(reader, 'History');
+
+    const [start, end] = reader.range;
+    const history: DeferredHistory = {
+      count: 0,
+      streamOffset: this.streamOffset,
+      start,
+      end,
+    };
+
+    // Nothing is parsed here, but the protected values still need to be
+    // accounted for to keep the random stream in sync with the rest of the
+    // document.
+    let protectedLength = 0;
+
+    while (reader.readNextStartElement()) {
+      if (reader.current.name === 'Entry') {
+        history.count++;
+      } else if (
+        KdbxXmlReader.isProtected(reader.current) &&
+        !reader.current.isClose
+      ) {
+        protectedLength += byteLength(reader.readElementText());
+      }
+    }
+
+    await this.seekRandomStream(this.streamOffset + protectedLength);
+
+    return history;
+  }
+
   private async parseEntryString(
     reader: XmlReader,
   ): Promise<[string, string, boolean]> {
@@ -754,7 +896,7 @@ export default class KdbxXmlReader {
       return [text, isProtected];
     }
 
-    const data = await this.randomStream.process(
+    const data = await this.processRandomStream(
       Uint8ArrayWriter.fromBase64(text),
     );
     return [Uint8ArrayReader.toString(data), isProtected];
@@ -809,7 +951,16 @@ export default class KdbxXmlReader {
       return date;
     }
 
-    throw new Error('Non-encoded dates not implemented');
+    // KDBX 3.1 stores dates as ISO 8601 strings in UTC
+    const date = new Date(value);
+    if (
+      !value.match(/^\d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}(\.\d+)?Z$/) ||
+      isNaN(date.getTime())
+    ) {
+      throw new Error(`Invalid date value "${value}"`);
+    }
+
+    return date;
   }
 
   private static readBoolean(reader: XmlReader): boolean {
@@ -856,14 +1007,29 @@ export default class KdbxXmlReader {
   }
 
   private async readBinary(reader: XmlReader): Promise<Uint8Array> {
+    // Reading the text moves to the close tag, so the attributes need to be
+    // checked first.
+    const isProtected = KdbxXmlReader.isProtected(reader.current);
     const value = reader.readElementText();
     let data = Uint8ArrayWriter.fromBase64(value);
-    if (KdbxXmlReader.isProtected(reader.current)) {
-      data = await this.randomStream.process(data);
+    if (isProtected) {
+      data = await this.processRandomStream(data);
     }
     return data;
   }
 
+  private async processRandomStream(data: Uint8Array): Promise<Uint8Array> {
+    this.streamOffset += data.byteLength;
+    return await this.randomStream.process(data);
+  }
+
+  private async seekRandomStream(offset: number): Promise<void> {
+    if (offset !== this.streamOffset) {
+      this.streamOffset = offset;
+      await this.randomStream.seek(offset);
+    }
+  }
+
   private static isProtected(element: XmlElement) {
     return element.attributes.Protected?.toLowerCase() === 'true';
   }
@@ -5,6 +5,10 @@ import SymmetricCipher, {
   SymmetricCipherMode,
 } from '../crypto/SymmetricCipher';
 
+const SALSA20_IV = Uint8Array.from([
+  0xe8, 0x30, 0x09, 0x4b, 0x97, 0x20, 0x5d, 0x2a,
+]);
+
 export default abstract class KeePass2RandomStream {
   static async create(
     mode: SymmetricCipherMode,
@@ -12,7 +16,12 @@ export default abstract class KeePass2RandomStream {
   ): Promise<Cipher> {
     switch (mode) {
       case SymmetricCipherMode.Salsa20:
-        throw new Error('Not implemented');
+        return SymmetricCipher.create(
+          SymmetricCipherMode.Salsa20,
+          SymmetricCipherDirection.Encrypt,
+          await CryptoHash.hash(key, CryptoHashAlgorithm.Sha256),
+          SALSA20_IV,
+        );
       case SymmetricCipherMode.ChaCha20: {
         const keyIv = await CryptoHash.hash(key, CryptoHashAlgorithm.Sha512);
         return SymmetricCipher.create(
@@ -0,0 +1,43 @@
+import {Database} from '../core/Database';
+import CompositeKey from '../keys/CompositeKey';
+import Uint8ArrayCursorReader from '../utilities/Uint8ArrayCursorReader';
+import Uint8ArrayReader from '../utilities/Uint8ArrayReader';
+import Kdbx3Reader from './Kdbx3Reader';
+import Kdbx4Reader from './Kdbx4Reader';
+import KdbxReader, {KdbxReaderOptions} from './KdbxReader';
+import {
+  FILE_VERSION_3,
+  FILE_VERSION_4,
+  FILE_VERSION_CRITICAL_MASK,
+  SIGNATURE_1,
+  SIGNATURE_2,
+} from './Keepass2';
+
+export default class KeePass2Reader {
+  constructor(private readonly options: KdbxReaderOptions = {}) {}
+
+  async readDatabase(bytes: Uint8Array, key: CompositeKey): Promise<Database> {
+    return await this.readerForFile(bytes).readDatabase(bytes, key);
+  }
+
+  private readerForFile(bytes: Uint8Array): KdbxReader {
+    const reader = new Uint8ArrayCursorReader(new Uint8ArrayReader(bytes));
+
+    const signatureOne = reader.readUInt32LE();
+    const signatureTwo = reader.readUInt32LE();
+    if (signatureOne !== SIGNATURE_1 || signatureTwo !== SIGNATURE_2) {
+      throw new Error('Not a KeePass database');
+    }
+
+    // eslint-disable-next-line no-bitwise
+    const version = reader.readUInt32LE() & FILE_VERSION_CRITICAL_MASK;
+    switch (version) {
+      case FILE_VERSION_3:
+        return new Kdbx3Reader(this.options);
+      case FILE_VERSION_4:
+        return new Kdbx4Reader(this.options);
+      default:
+        throw new Error('Unsupported KeePass 2 database version');
+    }
+  }
+}
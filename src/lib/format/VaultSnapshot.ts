@@ -0,0 +1,158 @@
+import {Database} from '../core/Database';
+import Entry from '../core/Entry';
+import Group from '../core/Group';
+import {Uuid} from '../core/types';
+import CryptoHash, {CryptoHashAlgorithm} from '../crypto/CryptoHash';
+import DomainMatcher from '../utilities/DomainMatcher';
+import KpHelperModule, {
+  NativeSnapshotEntry,
+} from '../utilities/KpHelperModule';
+import Uint8ArrayWriter from '../utilities/Uint8ArrayWriter';
+
+export interface SnapshotEntry {
+  uuid: Uuid;
+  attributes: Record<string, string>;
+}
+
+export interface Snapshot {
+  find(query: string): Promise<number[]>;
+
+  read(index: number): Promise<SnapshotEntry>;
+
+  close(): Promise<void>;
+}
+
+// Only the attributes autofill fills are copied into the snapshot
+const SNAPSHOT_ATTRIBUTES = ['Title', 'UserName', 'Password'];
+
+/**
+ * A snapshot is written each time its database is unlocked and is kept while
+ * the database is locked, so the autofill task can answer lookups without the
+ * database keys, even after a restart. Its key is random and wrapped by the
+ * Android Keystore on the native side. It is deleted when the file or its keys
+ * change, or when it no longer opens.
+ */
+export default class VaultSnapshot {
+  private static writing?: Promise<void>;
+
+  static async write(uri: string, database: Database): Promise<void> {
+    const writing = VaultSnapshot.writeSnapshot(uri, database);
+    VaultSnapshot.writing = writing;
+
+    try {
+      await writing;
+    } finally {
+      if (VaultSnapshot.writing === writing) {
+        VaultSnapshot.writing = undefined;
+      }
+    }
+  }
+
+  static async findEntries(
+    uri: string,
+    query: string,
+  ): Promise<SnapshotEntry[]> {
+    const snapshot = await VaultSnapshot.open(
+      await VaultSnapshot.nameForFile(uri),
+    );
+    if (!snapshot) {
+      return [];
+    }
+
+    try {
+      const indexes = await snapshot.find(query);
+
+      return await Promise.all(indexes.map(index => snapshot.read(index)));
+    } finally {
+      await snapshot.close();
+    }
+  }
+
+  static async delete(uri: string): Promise<void> {
+    // A write still in progress would otherwise recreate the snapshot
+    await VaultSnapshot.writing?.catch(() => undefined);
+
+    await KpHelperModule.deleteSnapshot(await VaultSnapshot.nameForFile(uri));
+  }
+
+  private static async open(name: string): Promise<Snapshot | undefined> {
+    try {
+      return await KpHelperModule.openSnapshot(name);
+    } catch (e) {
+      // Either the file or its key was replaced or damaged, it will not open
+      // again
+      await KpHelperModule.deleteSnapshot(name);
+      throw e;
+    }
+  }
+
+  private static async writeSnapshot(
+    uri: string,
+    database: Database,
+  ): Promise<void> {
+    const identity = database.getHeaderHash();
+    if (!database.rootGroup || !identity) {
+      throw new Error('Database not loaded');
+    }
+
+    const entries: NativeSnapshotEntry[] = [];
+    VaultSnapshot.collectEntries(
+      database.rootGroup,
+      database.metadata.recycleBinUuid,
+      entries,
+    );
+
+    const name = await VaultSnapshot.nameForFile(uri);
+
+    await KpHelperModule.writeSnapshot(name, identity, entries);
+  }
+
+  private static async nameForFile(uri: string): Promise<string> {
+    const hash = await CryptoHash.hash(
+      Uint8ArrayWriter.fromString(uri),
+      CryptoHashAlgorithm.Sha256,
+    );
+
+    return [...hash.subarray(0, 16)]
+      .map(byte => byte.toString(16).padStart(2, '0'))
+      .join('');
+  }
+
+  private static collectEntries(
+    group: Group,
+    recycleBinUuid: Uuid | undefined,
+    entries: NativeSnapshotEntry[],
+  ): void {
+    // Deleted entries should not be offered for lookups
+    if (recycleBinUuid && group.uuid === recycleBinUuid) {
+      return;
+    }
+
+    for (const entry of group.entries) {
+      entries.push(VaultSnapshot.toNativeEntry(entry));
+    }
+
+    for (const child of group.children) {
+      VaultSnapshot.collectEntries(child, recycleBinUuid, entries);
+    }
+  }
+
+  private static toNativeEntry(entry: Entry): NativeSnapshotEntry {
+    if (!entry.uuid) {
+      throw new Error('Entry without uuid');
+    }
+
+    const fields: string[] = [];
+    for (const key of SNAPSHOT_ATTRIBUTES) {
+      if (key in entry.attributes) {
+        fields.push(key, entry.attributes[key]);
+      }
+    }
+
+    return {
+      uuid: entry.uuid,
+      fields,
+      urls: DomainMatcher.entryUrls(entry),
+    };
+  }
+}
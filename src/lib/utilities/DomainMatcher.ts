@@ -0,0 +1,77 @@
+import Entry from '../core/Entry';
+import Group from '../core/Group';
+import KpHelperModule from './KpHelperModule';
+
+export enum DomainMatch {
+  None,
+  RegistrableDomain,
+  Host,
+  Package,
+}
+
+// Additional URLs stored by KeePass2Android and compatible clients
+const ADDITIONAL_URL_PREFIX = 'KP2A_URL';
+
+export default class DomainMatcher {
+  static async match(query: string, urls: string[]): Promise<DomainMatch[]> {
+    if (!urls.length) {
+      return [];
+    }
+
+    return await KpHelperModule.matchUrls(query, urls);
+  }
+
+  static async findEntries(group: Group, query: string): Promise<Entry[]> {
+    const entries: Entry[] = [];
+    const urls: string[] = [];
+    const urlEntryIndex: number[] = [];
+
+    DomainMatcher.collectUrls(group, entries, urls, urlEntryIndex);
+
+    const matches = await DomainMatcher.match(query, urls);
+
+    const bestMatches: DomainMatch[] = entries.map(() => DomainMatch.None);
+    matches.forEach((match, urlIndex) => {
+      const entryIndex = urlEntryIndex[urlIndex];
+      if (match > bestMatches[entryIndex]) {
+        bestMatches[entryIndex] = match;
+      }
+    });
+
+    return entries
+      .map((entry, index) => ({entry, match: bestMatches[index]}))
+      .filter(({match}) => match !== DomainMatch.None)
+      .sort((a, b) => b.match - a.match)
+      .map(({entry}) => entry);
+  }
+
+  static entryUrls(entry: Entry): string[] {
+    return Object.entries(entry.attributes)
+      .filter(
+        ([key, value]) =>
+          value.length &&
+          (key === 'URL' || key.startsWith(ADDITIONAL_URL_PREFIX)),
+      )
+      .map(([, value]) => value);
+  }
+
+  private static collectUrls(
+    group: Group,
+    entries: Entry[],
+    urls: string[],
+    urlEntryIndex: number[],
+  ): void {
+    for (const entry of group.entries) {
+      const entryIndex = entries.push(entry) - 1;
+
+      for (const url of DomainMatcher.entryUrls(entry)) {
+        urls.push(url);
+        urlEntryIndex.push(entryIndex);
+      }
+    }
+
+    for (const child of group.children) {
+      DomainMatcher.collectUrls(child, entries, urls, urlEntryIndex);
+    }
+  }
+}
@@ -1,6 +1,7 @@
 import {useCallback, useEffect, useState} from 'react';
 import {NativeEventEmitter, NativeModules} from 'react-native';
 
+import Attachment, {AttachmentStore} from '../core/Attachment';
 import {CryptoHashAlgorithm} from '../crypto/CryptoHash';
 import {Argon2Type, Argon2Version} from '../crypto/kdf/Argon2Kdf';
 import {
@@ -8,9 +9,23 @@ import {
   SymmetricCipherDirection,
   SymmetricCipherMode,
 } from '../crypto/SymmetricCipher';
+import {Snapshot, SnapshotEntry} from '../format/VaultSnapshot';
+import {DomainMatch} from './DomainMatcher';
 
 const {KpHelperModule: NativeModule} = NativeModules;
 
+export interface NativeSnapshotEntry {
+  uuid: string;
+  fields: string[];
+  urls: string[];
+}
+
+export interface FindEntriesResult {
+  title: string;
+  username: string;
+  password: string;
+}
+
 export interface NativeHelperModule {
   transformAesKdfKey(
     key: number[],
@@ -57,8 +72,49 @@ export interface NativeHelperModule {
 
   finishCipher(uuid: string, data: number[]): Promise<number[]>;
 
+  seekCipher(uuid: string, position: number): Promise<void>;
+
   destroyCipher(uuid: string): Promise<boolean>;
 
+  decryptKdbx3Payload(
+    mode: number,
+    key: number[],
+    iv: number[],
+    streamStartBytes: number[],
+    data: number[],
+  ): Promise<number[]>;
+
+  createAttachmentStore(encrypted: boolean): Promise<string>;
+
+  addAttachment(uuid: string, data: number[]): Promise<number>;
+
+  writeAttachment(uuid: string, id: number, uri: string): Promise<void>;
+
+  destroyAttachmentStore(uuid: string): Promise<void>;
+
+  matchUrls(query: string, urls: string[]): Promise<number[]>;
+
+  writeSnapshot(
+    name: string,
+    identity: number[],
+    entries: NativeSnapshotEntry[],
+  ): Promise<void>;
+
+  openSnapshot(name: string): Promise<string | null>;
+
+  findSnapshotEntries(uuid: string, query: string): Promise<number[]>;
+
+  readSnapshotEntry(uuid: string, index: number): Promise<string[]>;
+
+  closeSnapshot(uuid: string): Promise<void>;
+
+  deleteSnapshot(name: string): Promise<void>;
+
+  completeFindEntries(
+    requestId: string,
+    entries: FindEntriesResult[],
+  ): Promise<void>;
+
   getHardwareKeys(): Promise<Record<string, string>>;
 
   challengeResponse(deviceId: string, challenge: number[]): Promise<number[]>;
@@ -81,11 +137,64 @@ class CipherHandler implements Cipher {
     );
   }
 
+  async seek(position: number): Promise<void> {
+    await this.module.seekCipher(this.uuid, position);
+  }
+
   async destroy(): Promise<void> {
     await this.module.destroyCipher(this.uuid);
   }
 }
 
+class AttachmentStoreHandler implements AttachmentStore {
+  constructor(private module: NativeHelperModule, private uuid: string) {
+    //
+  }
+
+  async add(data: Uint8Array): Promise<Attachment> {
+    return {
+      id: await this.module.addAttachment(this.uuid, [...data]),
+      size: data.byteLength,
+    };
+  }
+
+  async write(attachment: Attachment, uri: string): Promise<void> {
+    await this.module.writeAttachment(this.uuid, attachment.id, uri);
+  }
+
+  async destroy(): Promise<void> {
+    await this.module.destroyAttachmentStore(this.uuid);
+  }
+}
+
+class SnapshotHandler implements Snapshot {
+  constructor(private module: NativeHelperModule, private uuid: string) {
+    //
+  }
+
+  async find(query: string): Promise<number[]> {
+    return await this.module.findSnapshotEntries(this.uuid, query);
+  }
+
+  async read(index: number): Promise<SnapshotEntry> {
+    const [uuid, ...fields] = await this.module.readSnapshotEntry(
+      this.uuid,
+      index,
+    );
+
+    const attributes: Record<string, string> = {};
+    for (let i = 0; i + 1 < fields.length; i += 2) {
+      attributes[fields[i]] = fields[i + 1];
+    }
+
+    return {uuid, attributes};
+  }
+
+  async close(): Promise<void> {
+    await this.module.closeSnapshot(this.uuid);
+  }
+}
+
 export class LocalHelperModule {
   constructor(private module: NativeHelperModule) {}
 
@@ -175,6 +284,63 @@ export class LocalHelperModule {
     );
   }
 
+  async decryptKdbx3Payload(
+    mode: SymmetricCipherMode,
+    key: Uint8Array,
+    iv: Uint8Array,
+    streamStartBytes: Uint8Array,
+    data: Uint8Array,
+  ): Promise<Uint8Array> {
+    return Uint8Array.from(
+      await this.module.decryptKdbx3Payload(
+        mode,
+        [...key],
+        [...iv],
+        [...streamStartBytes],
+        [...data],
+      ),
+    );
+  }
+
+  async createAttachmentStore(
+    encrypted: boolean = true,
+  ): Promise<AttachmentStore> {
+    return new AttachmentStoreHandler(
+      this.module,
+      await this.module.createAttachmentStore(encrypted),
+    );
+  }
+
+  async matchUrls(query: string, urls: string[]): Promise<DomainMatch[]> {
+    return await this.module.matchUrls(query, urls);
+  }
+
+  async writeSnapshot(
+    name: string,
+    identity: Uint8Array,
+    entries: NativeSnapshotEntry[],
+  ): Promise<void> {
+    await this.module.writeSnapshot(name, [...identity], entries);
+  }
+
+  // Resolves undefined when there is no snapshot for the name
+  async openSnapshot(name: string): Promise<Snapshot | undefined> {
+    const uuid = await this.module.openSnapshot(name);
+
+    return uuid ? new SnapshotHandler(this.module, uuid) : undefined;
+  }
+
+  async deleteSnapshot(name: string): Promise<void> {
+    await this.module.deleteSnapshot(name);
+  }
+
+  async completeFindEntries(
+    requestId: string,
+    entries: FindEntriesResult[],
+  ): Promise<void> {
+    await this.module.completeFindEntries(requestId, entries);
+  }
+
   async challengeResponse(
     deviceId: string,
     challenge: Uint8Array,
@@ -13,7 +13,11 @@ export class XmlReader {
   private readonly totalSize: number = 0;
   private currentElement: XmlElement;
 
-  constructor(private readonly contents: string) {
+  // The offset of the contents within the document the reader was split from
+  constructor(
+    private readonly contents: string,
+    private readonly offset: number = 0,
+  ) {
     this.totalSize = this.contents.length;
 
     const firstElement = this.readNextTag(0);
@@ -27,7 +31,16 @@ export class XmlReader {
     return this.currentElement;
   }
 
+  get range(): [number, number] {
+    return [this.offset, this.offset + this.totalSize];
+  }
+
   readFromCurrent(): XmlReader {
+    const start = this.currentElement.position[0];
+    return new XmlReader(this.readCurrentAsString(), this.offset + start);
+  }
+
+  readCurrentAsString(): string {
     const endTag = this.currentElement.isClose
       ? this.currentElement
       : this.findEndOfCurrentElement();
@@ -37,13 +50,14 @@ export class XmlReader {
       );
     }
 
-    const reader = new XmlReader(
-      this.contents.slice(this.currentElement.position[0], endTag.position[1]),
+    const contents = this.contents.slice(
+      this.currentElement.position[0],
+      endTag.position[1],
     );
 
     this.skipCurrentElement();
 
-    return reader;
+    return contents;
   }
 
   readNextStartElement(): boolean {
@@ -21,7 +21,8 @@ import {useLockState} from '../components/LockStateProvider';
 import ScrollViewFill from '../components/ScrollViewFill';
 import Text from '../components/Text';
 import useLightDark from '../hooks/useLightDark';
-import Kdbx4Reader from '../lib/format/Kdbx4Reader';
+import KeePass2Reader from '../lib/format/KeePass2Reader';
+import VaultSnapshot from '../lib/format/VaultSnapshot';
 import ChallengeResponseKey from '../lib/keys/ChallengeResponseKey';
 import CompositeKey from '../lib/keys/CompositeKey';
 import FileKey from '../lib/keys/FileKey';
@@ -103,7 +104,7 @@ const UnlockScreen: FunctionComponent<MainStackScreenProps<'Unlock'>> = ({
       const fileBytes = await KpHelperModule.readFile(activeFile.file.uri);
       console.log(`Read ${fileBytes.byteLength} bytes`);
 
-      const parser = new Kdbx4Reader();
+      const parser = new KeePass2Reader({deferHistory: true});
       const keys: Key[] = [];
 
       const passwordKey = new PasswordKey();
@@ -138,6 +139,10 @@ const UnlockScreen: FunctionComponent<MainStackScreenProps<'Unlock'>> = ({
         new CompositeKey(keys),
       );
 
+      VaultSnapshot.write(activeFile.file.uri, database).catch(error =>
+        console.warn('Failed to write snapshot', error),
+      );
+
       setUnlocking(false);
       unlockDatabase(database);
       navigation.navigate('Index');
@@ -1,9 +1,48 @@
+import AsyncStorage from '@react-native-async-storage/async-storage';
+
+import {ActiveFile} from '../components/ActiveFileProvider';
+import VaultSnapshot, {SnapshotEntry} from '../lib/format/VaultSnapshot';
+import KpHelperModule, {
+  FindEntriesResult,
+} from '../lib/utilities/KpHelperModule';
+
 interface FindEntriesTaskData {
+  requestId: string;
   search: string;
 }
 
+async function findEntries(search: string): Promise<SnapshotEntry[]> {
+  const storedFile = await AsyncStorage.getItem('loaded-file');
+  if (!storedFile) {
+    return [];
+  }
+
+  const activeFile: ActiveFile = JSON.parse(storedFile);
+
+  // The autofill service passes the package name of the app being filled
+  return await VaultSnapshot.findEntries(
+    activeFile.file.uri,
+    `androidapp://${search}`,
+  );
+}
+
 export default async function findEntriesTask(
   taskData: FindEntriesTaskData,
 ): Promise<void> {
-  console.log('Inside findEntriesTask, taskData: ', taskData);
+  let results: FindEntriesResult[] = [];
+
+  try {
+    const entries = await findEntries(taskData.search);
+
+    results = entries.map(entry => ({
+      title: entry.attributes.Title ?? '',
+      username: entry.attributes.UserName ?? '',
+      password: entry.attributes.Password ?? '',
+    }));
+  } catch (e) {
+    console.warn('Failed to find entries', e);
+  } finally {
+    // The autofill service waits for an answer either way
+    await KpHelperModule.completeFindEntries(taskData.requestId, results);
+  }
 }